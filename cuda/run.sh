@@ -9,6 +9,14 @@ IMAGE_PATTERN="../assets/mitosis/mitosis-5d%04d.tif"
 INDEX_0=0
 INDEX_N=335
 ROUNDS=${1:-0}
+DRIVER_FOLDER=../shared/build
+DRIVER=$DRIVER_FOLDER/benchmark
+PLUGIN=$BUILD_FOLDER/libbenchmark.so
+
+echo "Building benchmark driver"
+rm -rf $DRIVER_FOLDER
+cmake -G Ninja -S ../shared -B $DRIVER_FOLDER -D CMAKE_BUILD_TYPE=Release -D CMAKE_LINKER_TYPE=LLD -D CMAKE_CXX_COMPILER=clang++ > /dev/null 2>&1
+cmake --build $DRIVER_FOLDER > /dev/null 2>&1
 
 OUTPUT_FOLDER="$OUTPUT_FOLDER_BASE/cuda-acpp"
 TECH_NAME="PCUDA (AdaptiveCpp)"
@@ -20,15 +28,15 @@ mkdir -p "$OUTPUT_FOLDER/1D" "$OUTPUT_FOLDER/2D" "$OUTPUT_FOLDER/3D" "$OUTPUT_FO
 echo $TECH_NAME > "$OUTPUT_FOLDER/$TXT_FILENAME"
 
 echo "Running $TECH_NAME 1D benchmark"
-ACPP_DEBUG_LEVEL=0 $BUILD_FOLDER/benchmark $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/1D 22020096       > "$OUTPUT_FOLDER/1D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/1D/$LOG_FILENAME"
+ACPP_DEBUG_LEVEL=0 $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/1D $PLUGIN 22020096       > "$OUTPUT_FOLDER/1D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/1D/$LOG_FILENAME"
 echo "Running $TECH_NAME 2D benchmark"
-ACPP_DEBUG_LEVEL=0 $BUILD_FOLDER/benchmark $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/2D 256 86016      > "$OUTPUT_FOLDER/2D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/2D/$LOG_FILENAME"
+ACPP_DEBUG_LEVEL=0 $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/2D $PLUGIN 256 86016      > "$OUTPUT_FOLDER/2D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/2D/$LOG_FILENAME"
 echo "Running $TECH_NAME 3D benchmark"
-ACPP_DEBUG_LEVEL=0 $BUILD_FOLDER/benchmark $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/3D 256 256 336    > "$OUTPUT_FOLDER/3D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/3D/$LOG_FILENAME"
+ACPP_DEBUG_LEVEL=0 $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/3D $PLUGIN 256 256 336    > "$OUTPUT_FOLDER/3D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/3D/$LOG_FILENAME"
 echo "Running $TECH_NAME 4D benchmark"
-ACPP_DEBUG_LEVEL=0 $BUILD_FOLDER/benchmark $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/4D 256 256 2 168  > "$OUTPUT_FOLDER/4D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/4D/$LOG_FILENAME"
+ACPP_DEBUG_LEVEL=0 $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/4D $PLUGIN 256 256 2 168  > "$OUTPUT_FOLDER/4D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/4D/$LOG_FILENAME"
 echo "Running $TECH_NAME 5D benchmark"
-ACPP_DEBUG_LEVEL=0 $BUILD_FOLDER/benchmark $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/5D 256 256 2 24 7 > "$OUTPUT_FOLDER/5D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/5D/$LOG_FILENAME"
+ACPP_DEBUG_LEVEL=0 $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/5D $PLUGIN 256 256 2 24 7 > "$OUTPUT_FOLDER/5D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/5D/$LOG_FILENAME"
 echo "Results and logs saved in $(realpath $OUTPUT_FOLDER)"
 
 OUTPUT_FOLDER="$OUTPUT_FOLDER_BASE/cuda-nvcc"
@@ -41,13 +49,13 @@ mkdir -p "$OUTPUT_FOLDER/1D" "$OUTPUT_FOLDER/2D" "$OUTPUT_FOLDER/3D" "$OUTPUT_FO
 echo $TECH_NAME > "$OUTPUT_FOLDER/$TXT_FILENAME"
 
 echo "Running $TECH_NAME 1D benchmark"
-$BUILD_FOLDER/benchmark $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/1D 22020096       > "$OUTPUT_FOLDER/1D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/1D/$LOG_FILENAME"
+$DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/1D $PLUGIN 22020096       > "$OUTPUT_FOLDER/1D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/1D/$LOG_FILENAME"
 echo "Running $TECH_NAME 2D benchmark"
-$BUILD_FOLDER/benchmark $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/2D 256 86016      > "$OUTPUT_FOLDER/2D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/2D/$LOG_FILENAME"
+$DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/2D $PLUGIN 256 86016      > "$OUTPUT_FOLDER/2D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/2D/$LOG_FILENAME"
 echo "Running $TECH_NAME 3D benchmark"
-$BUILD_FOLDER/benchmark $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/3D 256 256 336    > "$OUTPUT_FOLDER/3D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/3D/$LOG_FILENAME"
+$DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/3D $PLUGIN 256 256 336    > "$OUTPUT_FOLDER/3D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/3D/$LOG_FILENAME"
 echo "Running $TECH_NAME 4D benchmark"
-$BUILD_FOLDER/benchmark $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/4D 256 256 2 168  > "$OUTPUT_FOLDER/4D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/4D/$LOG_FILENAME"
+$DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/4D $PLUGIN 256 256 2 168  > "$OUTPUT_FOLDER/4D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/4D/$LOG_FILENAME"
 echo "Running $TECH_NAME 5D benchmark"
-$BUILD_FOLDER/benchmark $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/5D 256 256 2 24 7 > "$OUTPUT_FOLDER/5D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/5D/$LOG_FILENAME"
+$DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/5D $PLUGIN 256 256 2 24 7 > "$OUTPUT_FOLDER/5D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/5D/$LOG_FILENAME"
 echo "Results and logs saved in $(realpath $OUTPUT_FOLDER)"
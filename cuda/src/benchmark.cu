@@ -6,15 +6,17 @@
 
 #include <utils.hpp>
 
-__global__ void invert_kernel(Image const* input, Image* output)
+template<typename T>
+__global__ void invert_kernel(Image<T> const* input, Image<T>* output)
 {
     size_t i = blockIdx.x * blockDim.x + threadIdx.x;
     if (i >= input->size)
         return;
-    output->data[i] = 255 - input->data[i];
+    output->data[i] = VoxelTraits<T>::max - input->data[i];
 }
 
-__global__ void threshold_kernel(Image const* input, Image* output, uint8_t threshold, uint8_t max_value)
+template<typename T>
+__global__ void threshold_kernel(Image<T> const* input, Image<T>* output, T threshold, T max_value)
 {
     size_t i = blockIdx.x * blockDim.x + threadIdx.x;
     if (i >= input->size)
@@ -22,8 +24,17 @@ __global__ void threshold_kernel(Image const* input, Image* output, uint8_t thre
     output->data[i] = input->data[i] > threshold ? max_value : 0;
 }
 
-template<typename Func = std::function<void(size_t, size_t)>>
-__device__ void window_map(Image* input, Window* window, size_t const index, Func&& func)
+template<typename T>
+__global__ void subtract_kernel(Image<T> const* input, Image<T> const* subtrahend, Image<T>* output)
+{
+    size_t i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= input->size)
+        return;
+    output->data[i] = input->data[i] - subtrahend->data[i];
+}
+
+template<typename T, typename Func = std::function<void(size_t, size_t)>>
+__device__ void window_map(Image<T>* input, Window* window, size_t const index, Func&& func, bool reflect = false)
 {
     int image_coord[VGL_ARR_SHAPE_SIZE];
     int window_coord[VGL_ARR_SHAPE_SIZE];
@@ -52,6 +63,8 @@ __device__ void window_map(Image* input, Window* window, size_t const index, Fun
             int off = window->offset[d];
             idim = ires / off;
             ires = ires - idim * off;
+            if (reflect)
+                idim = window->shape[d] - 1 - idim;
             window_coord[d] = idim + image_coord[d];
             int maxv = input->shape[d] - 1;
             if (window_coord[d] < 0)
@@ -66,15 +79,16 @@ __device__ void window_map(Image* input, Window* window, size_t const index, Fun
     }
 }
 
-__global__ void erode_kernel(Image* input, Image* output, Window* window)
+template<typename T>
+__global__ void erode_kernel(Image<T>* input, Image<T>* output, Window* window)
 {
     size_t i = blockIdx.x * blockDim.x + threadIdx.x;
     if (i >= input->size)
         return;
 
-    uint8_t pmin = 255;
+    T pmin = VoxelTraits<T>::max;
     window_map(input, window, i, [&](auto image_index, auto _) {
-        uint8_t v = input->data[image_index];
+        T v = input->data[image_index];
         if (v < pmin)
             pmin = v;
     });
@@ -82,7 +96,86 @@ __global__ void erode_kernel(Image* input, Image* output, Window* window)
     output->data[i] = pmin;
 }
 
-__global__ void convolve_kernel(Image* input, Image* output, Window* window)
+template<typename T>
+__global__ void dilate_kernel(Image<T>* input, Image<T>* output, Window* window)
+{
+    size_t i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= input->size)
+        return;
+
+    T pmax = 0;
+    window_map(input, window, i, [&](auto image_index, auto _) {
+        T v = input->data[image_index];
+        if (v > pmax)
+            pmax = v;
+    }, true);
+
+    output->data[i] = pmax;
+}
+
+template<typename T>
+__global__ void gradient_kernel(Image<T>* input, Image<T>* output, Window* window, bool symmetric)
+{
+    size_t i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= input->size)
+        return;
+
+    T pmin = VoxelTraits<T>::max;
+    T pmax = 0;
+    window_map(input, window, i, [&](auto image_index, auto _) {
+        T v = input->data[image_index];
+        if (v < pmin)
+            pmin = v;
+        if (symmetric && v > pmax)
+            pmax = v;
+    });
+
+    if (!symmetric)
+        window_map(input, window, i, [&](auto image_index, auto _) {
+            T v = input->data[image_index];
+            if (v > pmax)
+                pmax = v;
+        }, true);
+
+    output->data[i] = pmax - pmin;
+}
+
+template<typename T>
+__global__ void white_tophat_kernel(Image<T>* eroded, Image<T>* output, Window* window, Image<T>* source)
+{
+    size_t i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= eroded->size)
+        return;
+
+    T pmax = 0;
+    window_map(eroded, window, i, [&](auto image_index, auto _) {
+        T v = eroded->data[image_index];
+        if (v > pmax)
+            pmax = v;
+    }, true);
+
+    output->data[i] = source->data[i] - pmax;
+}
+
+template<typename T>
+__global__ void black_tophat_kernel(Image<T>* dilated, Image<T>* output, Window* window, Image<T>* source)
+{
+    size_t i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= dilated->size)
+        return;
+
+    T pmin = VoxelTraits<T>::max;
+    window_map(dilated, window, i, [&](auto image_index, auto _) {
+        T v = dilated->data[image_index];
+        if (v < pmin)
+            pmin = v;
+    });
+
+    output->data[i] = pmin - source->data[i];
+}
+
+template<typename T>
+__global__ void convolve_kernel(Image<T>* input, Image<T>* output, Window* window)
 {
     size_t i = blockIdx.x * blockDim.x + threadIdx.x;
     if (i >= input->size)
@@ -93,24 +186,213 @@ __global__ void convolve_kernel(Image* input, Image* output, Window* window)
         result += input->data[image_index] * window->data[window_index];
     });
 
-    output->data[i] = (uint8_t)result;
+    output->data[i] = (T)result;
 }
 
-DeviceImage* image_similar_device_from_host(Image* image)
+template<typename T>
+__global__ void pack_kernel(Image<T>* input, BinaryImage* output, T threshold)
 {
-    auto d_image = new DeviceImage();
-    auto tmp_image = Image();
-    cudaMalloc(&d_image->self, sizeof(Image));
+    size_t i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= output->size)
+        return;
+
+    size_t row_words = output->dimensions > 1 ? output->offset[2] : output->size;
+
+    size_t image_index = 0;
+    for (int d = output->dimensions; d >= 2; --d)
+        image_index += input->offset[d] * ((i / output->offset[d]) % output->shape[d]);
+
+    int x0 = (i % row_words) * BINARY_WORD_BITS;
+    int bits = min(BINARY_WORD_BITS, output->shape[1] - x0);
+
+    uint64_t word = 0;
+    for (int b = 0; b < bits; ++b)
+        if (input->data[image_index + (x0 + b) * input->offset[1]] > threshold)
+            word |= uint64_t(1) << b;
+
+    output->data[i] = word;
+}
+
+template<typename T>
+__global__ void unpack_kernel(BinaryImage* input, Image<T>* output, T max_value)
+{
+    size_t i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= output->size)
+        return;
+
+    size_t ires = i;
+    size_t word_index = 0;
+    int x = 0;
+
+    for (int d = output->dimensions; d >= 1; --d) {
+        int off = output->offset[d];
+        int idim = ires / off;
+        ires = ires - idim * off;
+        if (d == 1)
+            x = idim;
+        else
+            word_index += input->offset[d] * idim;
+    }
+    word_index += x / BINARY_WORD_BITS;
+
+    output->data[i] = (input->data[word_index] >> (x % BINARY_WORD_BITS)) & 1 ? max_value : 0;
+}
+
+__device__ size_t binary_row_words(BinaryImage* image)
+{
+    return image->dimensions > 1 ? image->offset[2] : image->size;
+}
+
+__device__ uint64_t binary_valid_mask(BinaryImage* image, size_t word)
+{
+    int tail = image->shape[1] % BINARY_WORD_BITS;
+    return word + 1 == binary_row_words(image) && tail != 0 ? (uint64_t(1) << tail) - 1 : ~uint64_t(0);
+}
+
+__device__ uint64_t binary_shifted(BinaryImage* input, size_t row_index, int word, int dx)
+{
+    int words = binary_row_words(input);
+    int width = input->shape[1];
+    uint64_t value = input->data[row_index + word];
+
+    if (dx > 0) {
+        uint64_t next = word + 1 < words ? input->data[row_index + word + 1] : 0;
+        value = (value >> dx) | (next << (BINARY_WORD_BITS - dx));
+
+        int limit = width - 1 - dx - word * BINARY_WORD_BITS;
+        if (limit < BINARY_WORD_BITS - 1) {
+            int last = width - 1;
+            uint64_t edge = (input->data[row_index + last / BINARY_WORD_BITS] >> (last % BINARY_WORD_BITS)) & 1;
+            uint64_t mask = limit < 0 ? ~uint64_t(0) : ~uint64_t(0) << (limit + 1);
+            value = (value & ~mask) | (edge ? mask : 0);
+        }
+    } else if (dx < 0) {
+        uint64_t prev = word > 0 ? input->data[row_index + word - 1] : 0;
+        value = (value << -dx) | (prev >> (BINARY_WORD_BITS + dx));
+
+        int limit = -dx - word * BINARY_WORD_BITS;
+        if (limit > 0) {
+            uint64_t edge = input->data[row_index] & 1;
+            uint64_t mask = (uint64_t(1) << limit) - 1;
+            value = (value & ~mask) | (edge ? mask : 0);
+        }
+    }
 
-    cudaMalloc(&d_image->data, image->size);
+    return value;
+}
+
+template<typename Func = std::function<void(uint64_t)>>
+__device__ void binary_window_map(BinaryImage* input, Window* window, size_t const index, bool reflect, Func&& func)
+{
+    int word_coord[VGL_ARR_SHAPE_SIZE];
+    int ires = index;
+    int idim = 0;
+
+    for (int d = input->dimensions; d >= 1; --d) {
+        int off = input->offset[d];
+        idim = ires / off;
+        ires = ires - idim * off;
+        word_coord[d] = idim;
+    }
+
+    size_t row_index = 0;
+    for (size_t window_index = 0; window_index < window->size; ++window_index) {
+        if (window->data[window_index] == 0)
+            continue;
+
+        ires = (int)window_index;
+        row_index = 0;
+        int dx = 0;
+
+        for (int d = input->dimensions; d > window->dimensions; --d)
+            row_index += input->offset[d] * word_coord[d];
+
+        for (int d = window->dimensions; d >= 1; --d) {
+            int off = window->offset[d];
+            idim = ires / off;
+            ires = ires - idim * off;
+
+            int delta = idim - (window->shape[d] - 1) / 2;
+            if (reflect)
+                delta = -delta;
+
+            if (d == 1) {
+                dx = delta;
+            } else {
+                int coord = word_coord[d] + delta;
+                int maxv = input->shape[d] - 1;
+                if (coord < 0)
+                    coord = 0;
+                else if (coord > maxv)
+                    coord = maxv;
+
+                row_index += input->offset[d] * coord;
+            }
+        }
+
+        func(binary_shifted(input, row_index, word_coord[1], dx));
+    }
+}
+
+__global__ void binary_erode_kernel(BinaryImage* input, BinaryImage* output, Window* window)
+{
+    size_t i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= input->size)
+        return;
+
+    uint64_t result = ~uint64_t(0);
+    binary_window_map(input, window, i, false, [&](auto word) {
+        result &= word;
+    });
+
+    output->data[i] = result & binary_valid_mask(input, i % binary_row_words(input));
+}
+
+__global__ void binary_dilate_kernel(BinaryImage* input, BinaryImage* output, Window* window)
+{
+    size_t i = blockIdx.x * blockDim.x + threadIdx.x;
+    if (i >= input->size)
+        return;
+
+    uint64_t result = 0;
+    binary_window_map(input, window, i, true, [&](auto word) {
+        result |= word;
+    });
+
+    output->data[i] = result & binary_valid_mask(input, i % binary_row_words(input));
+}
+
+template<typename T>
+cudaError_t device_malloc(T** pointer, size_t bytes)
+{
+    auto error = cudaMalloc(pointer, bytes);
+    if (error == cudaSuccess)
+        memory_track_device_allocation(*pointer, bytes);
+    return error;
+}
+
+void device_free(void* pointer)
+{
+    memory_track_device_free(pointer);
+    cudaFree(pointer);
+}
+
+template<typename T>
+DeviceImage<T>* image_similar_device_from_host(Image<T>* image)
+{
+    auto d_image = new DeviceImage<T>();
+    auto tmp_image = Image<T>();
+    device_malloc(&d_image->self, sizeof(Image<T>));
+
+    device_malloc(&d_image->data, image->size * sizeof(T));
     tmp_image.data = d_image->data;
 
-    cudaMalloc(&d_image->shape, image->dimensions * sizeof(int));
-    cudaMemcpy(d_image->shape, image->shape, image->dimensions * sizeof(int), cudaMemcpyHostToDevice);
+    device_malloc(&d_image->shape, (image->dimensions + 1) * sizeof(int));
+    cudaMemcpy(d_image->shape, image->shape, (image->dimensions + 1) * sizeof(int), cudaMemcpyHostToDevice);
     tmp_image.shape = d_image->shape;
 
-    cudaMalloc(&d_image->offset, image->dimensions * sizeof(int));
-    cudaMemcpy(d_image->offset, image->offset, image->dimensions * sizeof(int), cudaMemcpyHostToDevice);
+    device_malloc(&d_image->offset, (image->dimensions + 1) * sizeof(int));
+    cudaMemcpy(d_image->offset, image->offset, (image->dimensions + 1) * sizeof(int), cudaMemcpyHostToDevice);
     tmp_image.offset = d_image->offset;
 
     d_image->dimensions = image->dimensions;
@@ -118,21 +400,23 @@ DeviceImage* image_similar_device_from_host(Image* image)
     d_image->size = image->size;
     tmp_image.size = d_image->size;
 
-    cudaMemcpy(d_image->self, &tmp_image, sizeof(Image), cudaMemcpyHostToDevice);
+    cudaMemcpy(d_image->self, &tmp_image, sizeof(Image<T>), cudaMemcpyHostToDevice);
 
     return d_image;
 }
 
-DeviceImage* image_device_from_host(Image* image)
+template<typename T>
+DeviceImage<T>* image_device_from_host(Image<T>* image)
 {
     auto d_image = image_similar_device_from_host(image);
 
-    cudaMemcpy(d_image->data, image->data, image->size, cudaMemcpyHostToDevice);
+    cudaMemcpy(d_image->data, image->data, image->size * sizeof(T), cudaMemcpyHostToDevice);
 
     return d_image;
 }
 
-DeviceImage* image_device_convert_from_host(Image* image)
+template<typename T>
+DeviceImage<T>* image_device_convert_from_host(Image<T>* image)
 {
     auto d_image = image_device_from_host(image);
 
@@ -141,30 +425,76 @@ DeviceImage* image_device_convert_from_host(Image* image)
     return d_image;
 }
 
-void image_destroy_device(DeviceImage* d_image)
+template<typename T>
+void image_destroy_device(DeviceImage<T>* d_image)
 {
-    cudaFree(d_image->data);
-    cudaFree(d_image->shape);
-    cudaFree(d_image->offset);
-    cudaFree(d_image->self);
+    device_free(d_image->data);
+    device_free(d_image->shape);
+    device_free(d_image->offset);
+    device_free(d_image->self);
     delete d_image;
 }
 
+DeviceBinaryImage* binary_image_similar_device_from_host(BinaryImage* binary)
+{
+    auto d_binary = new DeviceBinaryImage();
+    auto tmp_binary = BinaryImage();
+    device_malloc(&d_binary->self, sizeof(BinaryImage));
+
+    device_malloc(&d_binary->data, binary->size * sizeof(uint64_t));
+    tmp_binary.data = d_binary->data;
+
+    device_malloc(&d_binary->shape, (binary->dimensions + 1) * sizeof(int));
+    cudaMemcpy(d_binary->shape, binary->shape, (binary->dimensions + 1) * sizeof(int), cudaMemcpyHostToDevice);
+    tmp_binary.shape = d_binary->shape;
+
+    device_malloc(&d_binary->offset, (binary->dimensions + 1) * sizeof(int));
+    cudaMemcpy(d_binary->offset, binary->offset, (binary->dimensions + 1) * sizeof(int), cudaMemcpyHostToDevice);
+    tmp_binary.offset = d_binary->offset;
+
+    d_binary->dimensions = binary->dimensions;
+    tmp_binary.dimensions = d_binary->dimensions;
+    d_binary->size = binary->size;
+    tmp_binary.size = d_binary->size;
+
+    cudaMemcpy(d_binary->self, &tmp_binary, sizeof(BinaryImage), cudaMemcpyHostToDevice);
+
+    return d_binary;
+}
+
+DeviceBinaryImage* binary_image_device_from_host(BinaryImage* binary)
+{
+    auto d_binary = binary_image_similar_device_from_host(binary);
+
+    cudaMemcpy(d_binary->data, binary->data, binary->size * sizeof(uint64_t), cudaMemcpyHostToDevice);
+
+    return d_binary;
+}
+
+void binary_image_destroy_device(DeviceBinaryImage* d_binary)
+{
+    device_free(d_binary->data);
+    device_free(d_binary->shape);
+    device_free(d_binary->offset);
+    device_free(d_binary->self);
+    delete d_binary;
+}
+
 DeviceWindow* window_similar_device_from_host(Window* window)
 {
     auto d_window = new DeviceWindow();
     auto tmp_window = Window();
-    cudaMalloc(&d_window->self, sizeof(Window));
+    device_malloc(&d_window->self, sizeof(Window));
 
-    cudaMalloc(&d_window->data, window->size * sizeof(float));
+    device_malloc(&d_window->data, window->size * sizeof(float));
     tmp_window.data = d_window->data;
 
-    cudaMalloc(&d_window->shape, window->dimensions * sizeof(int));
-    cudaMemcpy(d_window->shape, window->shape, window->dimensions * sizeof(int), cudaMemcpyHostToDevice);
+    device_malloc(&d_window->shape, (window->dimensions + 1) * sizeof(int));
+    cudaMemcpy(d_window->shape, window->shape, (window->dimensions + 1) * sizeof(int), cudaMemcpyHostToDevice);
     tmp_window.shape = d_window->shape;
 
-    cudaMalloc(&d_window->offset, window->dimensions * sizeof(int));
-    cudaMemcpy(d_window->offset, window->offset, window->dimensions * sizeof(int), cudaMemcpyHostToDevice);
+    device_malloc(&d_window->offset, (window->dimensions + 1) * sizeof(int));
+    cudaMemcpy(d_window->offset, window->offset, (window->dimensions + 1) * sizeof(int), cudaMemcpyHostToDevice);
     tmp_window.offset = d_window->offset;
 
     d_window->dimensions = window->dimensions;
@@ -197,17 +527,24 @@ DeviceWindow* window_device_convert_from_host(Window* window)
 
 void window_destroy_device(DeviceWindow* d_window)
 {
-    cudaFree(d_window->data);
-    cudaFree(d_window->shape);
-    cudaFree(d_window->offset);
-    cudaFree(d_window->self);
+    device_free(d_window->data);
+    device_free(d_window->shape);
+    device_free(d_window->offset);
+    device_free(d_window->self);
     delete d_window;
 }
 
-void benchmark(VglImage* vglimage, size_t rounds, std::function<void(VglImage*, std::string)> save_image)
+template<typename T>
+BenchmarkSession benchmark_voxel(Image<uint8_t>* source, VglImage* vglimage, size_t rounds, std::function<void(VglImage*, std::string)> save_image, bool header)
 {
-    auto image = image_from_vglimage(vglimage);
+    auto image = image_cast<T>(source);
+    auto sample = image_similar_from_image(image);
     auto dimensions = image->dimensions;
+    auto const bytes = image->size * sizeof(T);
+
+    auto const suffix = std::is_same_v<T, uint8_t> ? std::string() : std::string("-") + VoxelTraits<T>::name;
+    auto const threshold = voxel_from_uint8<T>(128);
+    auto const max_value = VoxelTraits<T>::max;
 
     auto const THREADS_PER_BLOCK = 256;
     auto const BLOCKS = (int)((image->size + THREADS_PER_BLOCK - 1) / THREADS_PER_BLOCK);
@@ -215,79 +552,82 @@ void benchmark(VglImage* vglimage, size_t rounds, std::function<void(VglImage*,
     auto d_input = image_device_from_host(image);
     auto d_output = image_similar_device_from_host(image);
     auto d_temp = image_similar_device_from_host(image);
+    auto d_extra = image_similar_device_from_host(image);
 
     auto d_cross_window = window_device_convert_from_host(window_create_from_type(WindowType::CROSS, dimensions));
-    auto d_cube_window = window_device_convert_from_host(window_create_from_type(WindowType::CUBE, dimensions));
+    auto cube_window = window_create_from_type(WindowType::CUBE, dimensions);
+    auto const cube_symmetric = window_symmetric(cube_window);
+    auto d_cube_window = window_device_convert_from_host(cube_window);
     auto d_mean_window = window_device_convert_from_host(window_create_from_type(WindowType::MEAN, dimensions));
 
     auto d_cube_window_array = new DeviceWindow*[dimensions + 1];
     auto d_mean_window_array = new DeviceWindow*[dimensions + 1];
-    {
-        auto cube_window_1d = window_create_from_type(WindowType::CUBE, 1);
-        auto mean_window_1d = window_create_from_type(WindowType::MEAN, 1);
-
-        for (int i = 1; i <= dimensions; ++i) {
-            cube_window_1d->shape[i] = 3;
-            mean_window_1d->shape[i] = 3;
-
-            d_cube_window_array[i] = window_device_from_host(cube_window_1d);
-            d_mean_window_array[i] = window_device_from_host(mean_window_1d);
+    for (int i = 1; i <= dimensions; ++i) {
+        d_cube_window_array[i] = window_device_convert_from_host(window_create_axis_from_type(WindowType::CUBE, dimensions, i));
+        d_mean_window_array[i] = window_device_convert_from_host(window_create_axis_from_type(WindowType::MEAN, dimensions, i));
+    }
 
-            cube_window_1d->shape[i] = 1;
-            mean_window_1d->shape[i] = 1;
-        }
+    auto binary = binary_image_from_image(image, threshold);
+    auto const BINARY_BLOCKS = (int)((binary->size + THREADS_PER_BLOCK - 1) / THREADS_PER_BLOCK);
 
-        window_destroy(cube_window_1d);
-        window_destroy(mean_window_1d);
-    }
+    auto d_binary_input = binary_image_device_from_host(binary);
+    auto d_binary_output = binary_image_similar_device_from_host(binary);
+    auto d_binary_temp = binary_image_similar_device_from_host(binary);
 
     auto save_sample = [&](std::string name) {
-        cudaMemcpy(vglimage->getImageData(), d_output->data, image->size, cudaMemcpyDeviceToHost);
+        cudaMemcpy(sample->data, d_output->data, bytes, cudaMemcpyDeviceToHost);
+        image_to_vglimage(sample, vglimage);
         save_image(vglimage, name);
     };
 
+    auto save_binary_sample = [&](std::string name) {
+        unpack_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_binary_output->self, d_output->self, max_value);
+        cudaDeviceSynchronize();
+        save_sample(name);
+    };
+
     auto builder = BenchmarkBuilder();
     builder.attach({
-        .name = "upload",
+        .name = "upload" + suffix,
         .type = "group",
         .group = "memory",
-        .func = [&] { cudaMemcpy(d_input->data, image->data, image->size, cudaMemcpyHostToDevice); },
+        .func = [&] { cudaMemcpy(d_input->data, image->data, bytes, cudaMemcpyHostToDevice); },
     });
     builder.attach({
-        .name = "download",
+        .name = "download" + suffix,
         .type = "group",
         .group = "memory",
-        .func = [&] { cudaMemcpy(image->data, d_output->data, image->size, cudaMemcpyDeviceToHost); },
+        .func = [&] { cudaMemcpy(image->data, d_output->data, bytes, cudaMemcpyDeviceToHost); },
     });
     builder.attach({
-        .name = "copy",
+        .name = "copy" + suffix,
         .type = "group",
         .group = "memory",
         .post = save_sample,
-        .func = [&] { cudaMemcpy(d_output->data, d_input->data, image->size, cudaMemcpyDeviceToDevice); },
+        .func = [&] { cudaMemcpy(d_output->data, d_input->data, bytes, cudaMemcpyDeviceToDevice); },
     });
     builder.attach({
-        .name = "invert",
+        .name = "invert" + suffix,
         .type = "group",
         .group = "point",
         .post = save_sample,
         .func = [&] {
-            invert_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_input->self);
+            invert_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_output->self);
             cudaDeviceSynchronize();
         },
     });
     builder.attach({
-        .name = "threshold",
+        .name = "threshold" + suffix,
         .type = "group",
         .group = "point",
         .post = save_sample,
         .func = [&] {
-            threshold_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_output->self, 128, 255);
+            threshold_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_output->self, threshold, max_value);
             cudaDeviceSynchronize();
         },
     });
     builder.attach({
-        .name = "erode-cube",
+        .name = "erode-cube" + suffix,
         .type = "single",
         .post = save_sample,
         .func = [&] {
@@ -296,7 +636,7 @@ void benchmark(VglImage* vglimage, size_t rounds, std::function<void(VglImage*,
         },
     });
     builder.attach({
-        .name = "split-erode-cube",
+        .name = "split-erode-cube" + suffix,
         .type = "single",
         .post = save_sample,
         .func = [&] {
@@ -311,12 +651,12 @@ void benchmark(VglImage* vglimage, size_t rounds, std::function<void(VglImage*,
                 cudaDeviceSynchronize();
             }
             if (dimensions & 0b1) {
-                cudaMemcpy(d_output->data, d_temp->data, image->size, cudaMemcpyDeviceToDevice);
+                cudaMemcpy(d_output->data, d_temp->data, bytes, cudaMemcpyDeviceToDevice);
             }
         },
     });
     builder.attach({
-        .name = "erode-cross",
+        .name = "erode-cross" + suffix,
         .type = "single",
         .post = save_sample,
         .func = [&] {
@@ -325,7 +665,7 @@ void benchmark(VglImage* vglimage, size_t rounds, std::function<void(VglImage*,
         },
     });
     builder.attach({
-        .name = "convolve",
+        .name = "convolve" + suffix,
         .type = "single",
         .post = save_sample,
         .func = [&] {
@@ -334,7 +674,7 @@ void benchmark(VglImage* vglimage, size_t rounds, std::function<void(VglImage*,
         },
     });
     builder.attach({
-        .name = "split-convolve",
+        .name = "split-convolve" + suffix,
         .type = "single",
         .post = save_sample,
         .func = [&] {
@@ -348,16 +688,214 @@ void benchmark(VglImage* vglimage, size_t rounds, std::function<void(VglImage*,
                 cudaDeviceSynchronize();
             }
             if (dimensions & 0b1) {
-                cudaMemcpy(d_output->data, d_temp->data, image->size, cudaMemcpyDeviceToDevice);
+                cudaMemcpy(d_output->data, d_temp->data, bytes, cudaMemcpyDeviceToDevice);
+            }
+        },
+    });
+    builder.attach({
+        .name = "dilate-cross" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            dilate_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_output->self, d_cross_window->self);
+            cudaDeviceSynchronize();
+        },
+    });
+    builder.attach({
+        .name = "dilate-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            dilate_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_output->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+        },
+    });
+    builder.attach({
+        .name = "split-dilate-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            dilate_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_temp->self, d_cube_window_array[1]->self);
+            cudaDeviceSynchronize();
+            for (int i = 2; i <= dimensions; ++i) {
+                if (i & 0b1) {
+                    dilate_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_output->self, d_temp->self, d_cube_window_array[i]->self);
+                } else {
+                    dilate_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_temp->self, d_output->self, d_cube_window_array[i]->self);
+                }
+                cudaDeviceSynchronize();
+            }
+            if (dimensions & 0b1) {
+                cudaMemcpy(d_output->data, d_temp->data, bytes, cudaMemcpyDeviceToDevice);
+            }
+        },
+    });
+    builder.attach({
+        .name = "open-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            erode_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_temp->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+            dilate_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_temp->self, d_output->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+        },
+    });
+    builder.attach({
+        .name = "close-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            dilate_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_temp->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+            erode_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_temp->self, d_output->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+        },
+    });
+    builder.attach({
+        .name = "gradient-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            gradient_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_output->self, d_cube_window->self, cube_symmetric);
+            cudaDeviceSynchronize();
+        },
+    });
+    builder.attach({
+        .name = "naive-gradient-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            dilate_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_temp->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+            erode_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_extra->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+            subtract_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_temp->self, d_extra->self, d_output->self);
+            cudaDeviceSynchronize();
+        },
+    });
+    builder.attach({
+        .name = "tophat-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            erode_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_temp->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+            white_tophat_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_temp->self, d_output->self, d_cube_window->self, d_input->self);
+            cudaDeviceSynchronize();
+        },
+    });
+    builder.attach({
+        .name = "naive-tophat-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            erode_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_temp->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+            dilate_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_temp->self, d_extra->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+            subtract_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_extra->self, d_output->self);
+            cudaDeviceSynchronize();
+        },
+    });
+    builder.attach({
+        .name = "blackhat-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            dilate_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_temp->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+            black_tophat_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_temp->self, d_output->self, d_cube_window->self, d_input->self);
+            cudaDeviceSynchronize();
+        },
+    });
+    builder.attach({
+        .name = "naive-blackhat-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            dilate_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_temp->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+            erode_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_temp->self, d_extra->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+            subtract_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_extra->self, d_input->self, d_output->self);
+            cudaDeviceSynchronize();
+        },
+    });
+    builder.attach({
+        .name = "threshold-erode-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            threshold_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_temp->self, threshold, max_value);
+            cudaDeviceSynchronize();
+            erode_kernel<<<BLOCKS, THREADS_PER_BLOCK>>>(d_temp->self, d_output->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+        },
+    });
+    builder.attach({
+        .name = "binary-erode-cube" + suffix,
+        .type = "single",
+        .post = save_binary_sample,
+        .func = [&] {
+            binary_erode_kernel<<<BINARY_BLOCKS, THREADS_PER_BLOCK>>>(d_binary_input->self, d_binary_output->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+        },
+    });
+    builder.attach({
+        .name = "binary-dilate-cube" + suffix,
+        .type = "single",
+        .post = save_binary_sample,
+        .func = [&] {
+            binary_dilate_kernel<<<BINARY_BLOCKS, THREADS_PER_BLOCK>>>(d_binary_input->self, d_binary_output->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+        },
+    });
+    builder.attach({
+        .name = "binary-threshold-erode-cube" + suffix,
+        .type = "single",
+        .post = save_binary_sample,
+        .func = [&] {
+            pack_kernel<<<BINARY_BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_binary_temp->self, threshold);
+            cudaDeviceSynchronize();
+            binary_erode_kernel<<<BINARY_BLOCKS, THREADS_PER_BLOCK>>>(d_binary_temp->self, d_binary_output->self, d_cube_window->self);
+            cudaDeviceSynchronize();
+        },
+    });
+    builder.attach({
+        .name = "binary-threshold-split-erode-cube" + suffix,
+        .type = "single",
+        .post = save_binary_sample,
+        .func = [&] {
+            pack_kernel<<<BINARY_BLOCKS, THREADS_PER_BLOCK>>>(d_input->self, d_binary_temp->self, threshold);
+            cudaDeviceSynchronize();
+            for (int i = 1; i <= dimensions; ++i) {
+                if (i & 0b1)
+                    binary_erode_kernel<<<BINARY_BLOCKS, THREADS_PER_BLOCK>>>(d_binary_temp->self, d_binary_output->self, d_cube_window_array[i]->self);
+                else
+                    binary_erode_kernel<<<BINARY_BLOCKS, THREADS_PER_BLOCK>>>(d_binary_output->self, d_binary_temp->self, d_cube_window_array[i]->self);
+                cudaDeviceSynchronize();
+            }
+            if (!(dimensions & 0b1)) {
+                cudaMemcpy(d_binary_output->data, d_binary_temp->data, binary->size * sizeof(uint64_t), cudaMemcpyDeviceToDevice);
             }
         },
     });
-    builder.run(rounds);
+    for (size_t round = 0; round < rounds; ++round) {
+        co_await std::suspend_always();
+        builder.run(round, header);
+    }
 
     image_destroy(image);
+    image_destroy(sample);
+    binary_image_destroy(binary);
+    binary_image_destroy_device(d_binary_input);
+    binary_image_destroy_device(d_binary_output);
+    binary_image_destroy_device(d_binary_temp);
     image_destroy_device(d_input);
     image_destroy_device(d_output);
     image_destroy_device(d_temp);
+    image_destroy_device(d_extra);
     window_destroy_device(d_cross_window);
     window_destroy_device(d_cube_window);
     window_destroy_device(d_mean_window);
@@ -368,3 +906,19 @@ void benchmark(VglImage* vglimage, size_t rounds, std::function<void(VglImage*,
     delete[] d_cube_window_array;
     delete[] d_mean_window_array;
 }
+
+BenchmarkSession benchmark(VglImage* vglimage, size_t rounds, std::function<void(VglImage*, std::string)> save_image)
+{
+    auto source = image_from_vglimage<uint8_t>(vglimage);
+
+    co_yield benchmark_voxel<uint8_t>(source, vglimage, rounds, save_image, true);
+    co_yield benchmark_voxel<uint16_t>(source, vglimage, rounds, save_image, false);
+    co_yield benchmark_voxel<float>(source, vglimage, rounds, save_image, false);
+
+    image_destroy(source);
+}
+
+BENCHMARK_PLUGIN_EXPORT BenchmarkPlugin const benchmark_plugin = {
+    .version = BENCHMARK_PLUGIN_VERSION,
+    .setup = benchmark,
+};
@@ -6,6 +6,7 @@ import matplotlib.pyplot as plot
 import numpy as np
 
 OUTPUT_DIR = "results"
+INTERLEAVED_DIR = "interleaved"
 TXT_FILENAME = "benchmark.txt"
 CSV_FILENAME = "benchmark.csv"
 
@@ -28,9 +29,40 @@ def main():
     tech_color_map: dict[str, str] = {}
     rgroup_map: dict[str, dict[str, dict[str, list[float]]]] = {}
     rsingle_map: dict[str, dict[str, dict[int, list[float]]]] = {}
+
+    # Interleaved reports hold every backend the driver ran, led by backend and round
+    def read_results(path: str, dimension: int, tech: str | None = None):
+        with open(path) as results:
+            reader = csv.reader(results)
+            interleaved = next(reader)[0] == "backend"
+            for row in reader:
+                if interleaved:
+                    tech, row = row[0], row[2:]
+                operator, rtype, group, duration = row[:4]
+
+                if rtype == "group":
+                    if rgroup_map.get(group) is None:
+                        rgroup_map[group] = {}
+                    if rgroup_map[group].get(operator) is None:
+                        rgroup_map[group][operator] = {}
+                    if rgroup_map[group][operator].get(tech) is None:
+                        rgroup_map[group][operator][tech] = []
+                    rgroup_map[group][operator][tech].append(np.float64(duration))
+                if rtype == "single":
+                    if rsingle_map.get(operator) is None:
+                        rsingle_map[operator] = {}
+                    if rsingle_map[operator].get(tech) is None:
+                        rsingle_map[operator][tech] = {}
+                    if rsingle_map[operator][tech].get(dimension) is None:
+                        rsingle_map[operator][tech][dimension] = []
+                    rsingle_map[operator][tech][dimension].append(np.float64(duration))
+
+                if tech_name_map.get(tech) is None:
+                    tech_name_map[tech] = tech
+
     for tech in sorted(os.listdir(OUTPUT_DIR)):
         tech_path = os.path.join(OUTPUT_DIR, tech)
-        if not os.path.isdir(tech_path):
+        if not os.path.isdir(tech_path) or tech == INTERLEAVED_DIR:
             continue
 
         with open(os.path.join(tech_path, TXT_FILENAME)) as name:
@@ -42,30 +74,17 @@ def main():
                 continue
 
             dimension = int("".join(filter(str.isdigit, dimension)))
-            with open(os.path.join(results_path, CSV_FILENAME)) as results:
-                reader = csv.reader(results)
-                next(reader)
-                for row in reader:
-                    operator, rtype, group, duration = row
-
-                    if rtype == "group":
-                        if rgroup_map.get(group) is None:
-                            rgroup_map[group] = {}
-                        if rgroup_map[group].get(operator) is None:
-                            rgroup_map[group][operator] = {}
-                        if rgroup_map[group][operator].get(tech) is None:
-                            rgroup_map[group][operator][tech] = []
-                        rgroup_map[group][operator][tech].append(np.float64(duration))
-                    if rtype == "single":
-                        if rsingle_map.get(operator) is None:
-                            rsingle_map[operator] = {}
-                        if rsingle_map[operator].get(tech) is None:
-                            rsingle_map[operator][tech] = {}
-                        if rsingle_map[operator][tech].get(dimension) is None:
-                            rsingle_map[operator][tech][dimension] = []
-                        rsingle_map[operator][tech][dimension].append(
-                            np.float64(duration)
-                        )
+            read_results(os.path.join(results_path, CSV_FILENAME), dimension, tech)
+
+    interleaved_path = os.path.join(OUTPUT_DIR, INTERLEAVED_DIR)
+    if os.path.isdir(interleaved_path):
+        for dimension in sorted(os.listdir(interleaved_path)):
+            results_path = os.path.join(interleaved_path, dimension)
+            if not os.path.isdir(results_path):
+                continue
+
+            dimension = int("".join(filter(str.isdigit, dimension)))
+            read_results(os.path.join(results_path, CSV_FILENAME), dimension)
 
     for tech in tech_name_map.keys():
         tech_color_map[tech] = color_list.pop()
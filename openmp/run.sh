@@ -0,0 +1,75 @@
+#!/usr/bin/env bash
+
+BUILD_FOLDER=./build
+TXT_FILENAME="benchmark.txt"
+CSV_FILENAME="benchmark.csv"
+LOG_FILENAME="benchmark.log"
+OUTPUT_FOLDER_BASE="../results"
+IMAGE_PATTERN="../assets/mitosis/mitosis-5d%04d.tif"
+INDEX_0=0
+INDEX_N=335
+ROUNDS=${1:-0}
+DRIVER_FOLDER=../shared/build
+DRIVER=$DRIVER_FOLDER/benchmark
+PLUGIN=$BUILD_FOLDER/libbenchmark.so
+
+echo "Building benchmark driver"
+rm -rf $DRIVER_FOLDER
+cmake -G Ninja -S ../shared -B $DRIVER_FOLDER -D CMAKE_BUILD_TYPE=Release -D CMAKE_LINKER_TYPE=LLD -D CMAKE_CXX_COMPILER=clang++ > /dev/null 2>&1
+cmake --build $DRIVER_FOLDER > /dev/null 2>&1
+
+OUTPUT_FOLDER="$OUTPUT_FOLDER_BASE/openmp"
+TECH_NAME="OpenMP"
+echo "Building $TECH_NAME benchmark"
+rm -rf $BUILD_FOLDER
+cmake -G Ninja -S . -B $BUILD_FOLDER -D CMAKE_BUILD_TYPE=Release -D CMAKE_LINKER_TYPE=LLD -D CMAKE_CXX_COMPILER=clang++ > /dev/null 2>&1
+cmake --build $BUILD_FOLDER > /dev/null 2>&1
+mkdir -p "$OUTPUT_FOLDER/1D" "$OUTPUT_FOLDER/2D" "$OUTPUT_FOLDER/3D" "$OUTPUT_FOLDER/4D" "$OUTPUT_FOLDER/5D"
+echo $TECH_NAME > "$OUTPUT_FOLDER/$TXT_FILENAME"
+echo "Running $TECH_NAME 1D benchmark"
+$DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/1D $PLUGIN 22020096       > "$OUTPUT_FOLDER/1D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/1D/$LOG_FILENAME"
+echo "Running $TECH_NAME 2D benchmark"
+$DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/2D $PLUGIN 256 86016      > "$OUTPUT_FOLDER/2D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/2D/$LOG_FILENAME"
+echo "Running $TECH_NAME 3D benchmark"
+$DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/3D $PLUGIN 256 256 336    > "$OUTPUT_FOLDER/3D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/3D/$LOG_FILENAME"
+echo "Running $TECH_NAME 4D benchmark"
+$DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/4D $PLUGIN 256 256 2 168  > "$OUTPUT_FOLDER/4D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/4D/$LOG_FILENAME"
+echo "Running $TECH_NAME 5D benchmark"
+$DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/5D $PLUGIN 256 256 2 24 7 > "$OUTPUT_FOLDER/5D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/5D/$LOG_FILENAME"
+echo "Results and logs saved in $(realpath $OUTPUT_FOLDER)"
+
+# Cores listed socket by socket so that close binding fills one socket before the next, one place per core
+SOCKETS=$(lscpu -p=SOCKET | grep -v '^#' | sort -u | wc -l)
+CORES_PER_SOCKET=$(lscpu -p=CORE,SOCKET | grep -v '^#' | sort -u | grep -c ',0$')
+PLACES=$(lscpu -p=CPU,CORE,SOCKET | grep -v '^#' | sort -t, -k3,3n -k2,2n | awk -F, '!seen[$2","$3]++ { printf "%s{%s}", sep, $1; sep = "," }')
+
+for BINDING in close spread; do
+    for ((SOCKET_COUNT = 1; SOCKET_COUNT <= SOCKETS; ++SOCKET_COUNT)); do
+        # Scattering over every socket with all cores busy is the compact run again
+        if [ $BINDING = spread ] && [ $SOCKET_COUNT = $SOCKETS ]; then
+            continue
+        fi
+        THREADS=$((SOCKET_COUNT * CORES_PER_SOCKET))
+        if [ $BINDING = close ]; then
+            OUTPUT_FOLDER="$OUTPUT_FOLDER_BASE/openmp-compact-$SOCKET_COUNT"
+            TECH_NAME="OpenMP (compact, $THREADS threads on $SOCKET_COUNT of $SOCKETS sockets)"
+        else
+            OUTPUT_FOLDER="$OUTPUT_FOLDER_BASE/openmp-scatter-$SOCKET_COUNT"
+            TECH_NAME="OpenMP (scatter, $THREADS threads over $SOCKETS sockets)"
+        fi
+        export OMP_NUM_THREADS=$THREADS OMP_PLACES=$PLACES OMP_PROC_BIND=$BINDING
+        mkdir -p "$OUTPUT_FOLDER/1D" "$OUTPUT_FOLDER/2D" "$OUTPUT_FOLDER/3D" "$OUTPUT_FOLDER/4D" "$OUTPUT_FOLDER/5D"
+        echo $TECH_NAME > "$OUTPUT_FOLDER/$TXT_FILENAME"
+        echo "Running $TECH_NAME 1D benchmark"
+        $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/1D $PLUGIN 22020096       > "$OUTPUT_FOLDER/1D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/1D/$LOG_FILENAME"
+        echo "Running $TECH_NAME 2D benchmark"
+        $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/2D $PLUGIN 256 86016      > "$OUTPUT_FOLDER/2D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/2D/$LOG_FILENAME"
+        echo "Running $TECH_NAME 3D benchmark"
+        $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/3D $PLUGIN 256 256 336    > "$OUTPUT_FOLDER/3D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/3D/$LOG_FILENAME"
+        echo "Running $TECH_NAME 4D benchmark"
+        $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/4D $PLUGIN 256 256 2 168  > "$OUTPUT_FOLDER/4D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/4D/$LOG_FILENAME"
+        echo "Running $TECH_NAME 5D benchmark"
+        $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/5D $PLUGIN 256 256 2 24 7 > "$OUTPUT_FOLDER/5D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/5D/$LOG_FILENAME"
+        echo "Results and logs saved in $(realpath $OUTPUT_FOLDER)"
+    done
+done
@@ -0,0 +1,1660 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <omp.h>
+#include <visiongl/constants.hpp>
+#include <visiongl/image.hpp>
+#include <visiongl/strel.hpp>
+
+#include <utils.hpp>
+
+template<typename Kernel>
+void parallel_for(size_t size, Kernel const& kernel)
+{
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < size; ++i)
+        kernel(i);
+}
+
+template<typename T>
+class Kernel {
+protected:
+    Image<T>* m_input;
+    Image<T>* m_output;
+
+public:
+    Kernel(Image<T>* input, Image<T>* output)
+        : m_input(input)
+        , m_output(output)
+    {
+    }
+};
+
+template<typename T>
+class FillKernel {
+private:
+    Image<T>* m_output;
+    T m_value;
+
+public:
+    FillKernel(Image<T>* output, T value)
+        : m_output(output)
+        , m_value(value)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        m_output->data[i] = m_value;
+    }
+};
+
+template<typename T>
+class InvertKernel : public Kernel<T> {
+    using Kernel<T>::m_input;
+    using Kernel<T>::m_output;
+
+public:
+    using Kernel<T>::Kernel;
+
+    void operator()(size_t i) const
+    {
+        m_output->data[i] = VoxelTraits<T>::max - m_input->data[i];
+    }
+};
+
+template<typename T>
+class ThresholdKernel : public Kernel<T> {
+    using Kernel<T>::m_input;
+    using Kernel<T>::m_output;
+
+private:
+    T m_threshold;
+    T m_max_value;
+
+public:
+    ThresholdKernel(Image<T>* input, Image<T>* output, T threshold, T max_value)
+        : Kernel<T>(input, output)
+        , m_threshold(threshold)
+        , m_max_value(max_value)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        m_output->data[i] = m_input->data[i] > m_threshold ? m_max_value : 0;
+    }
+};
+
+template<typename T>
+class WindowKernel : public Kernel<T> {
+protected:
+    using Kernel<T>::m_input;
+    using Kernel<T>::m_output;
+
+    Window* m_window;
+
+public:
+    WindowKernel(Image<T>* input, Image<T>* output, Window* window)
+        : Kernel<T>(input, output)
+        , m_window(window)
+    {
+    }
+
+    template<typename Func = std::function<void(size_t, size_t)>>
+    inline auto map(size_t index, Func&& apply) const
+    {
+        map(m_window, index, apply);
+    }
+
+    template<typename Func = std::function<void(size_t, size_t)>>
+    inline auto map(Window* window, size_t index, Func&& apply) const
+    {
+        int image_coord[VGL_ARR_SHAPE_SIZE];
+        int window_coord[VGL_ARR_SHAPE_SIZE];
+        int ires = index;
+        int idim = 0;
+
+        for (int d = m_input->dimensions; d >= 1; --d) {
+            int off = m_input->offset[d];
+            idim = ires / off;
+            ires = ires - idim * off;
+            image_coord[d] = idim - (window->shape[d] - 1) / 2;
+        }
+
+        size_t image_index = 0;
+        for (size_t window_index = 0; window_index < window->size; ++window_index) {
+            if (window->data[window_index] == 0)
+                continue;
+
+            ires = window_index;
+            image_index = 0;
+
+            for (int d = m_input->dimensions; d > window->dimensions; --d)
+                image_index += m_input->offset[d] * image_coord[d];
+
+            for (int d = window->dimensions; d >= 1; --d) {
+                int off = window->offset[d];
+                idim = ires / off;
+                ires = ires - idim * off;
+                window_coord[d] = idim + image_coord[d];
+                window_coord[d] = std::clamp(window_coord[d], 0, m_input->shape[d] - 1);
+
+                image_index += m_input->offset[d] * window_coord[d];
+            }
+
+            apply(image_index, window_index);
+        }
+    }
+};
+
+template<typename T>
+class ErodeKernel : public WindowKernel<T> {
+    using WindowKernel<T>::m_input;
+    using WindowKernel<T>::m_output;
+    using WindowKernel<T>::map;
+
+public:
+    using WindowKernel<T>::WindowKernel;
+
+    void operator()(size_t i) const
+    {
+        T pmin = VoxelTraits<T>::max;
+
+        map(i, [&](auto image_index, auto _) {
+            pmin = std::min(pmin, m_input->data[image_index]);
+        });
+
+        m_output->data[i] = pmin;
+    }
+};
+
+template<typename T, int N>
+inline void sort_network(T* values)
+{
+    for (int p = 1; p < N; p <<= 1)
+        for (int k = p; k >= 1; k >>= 1)
+            for (int j = k % p; j + k < N; j += 2 * k)
+                for (int i = 0; i < k && i + j + k < N; ++i)
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p)) {
+                        auto low = std::min(values[i + j], values[i + j + k]);
+                        auto high = std::max(values[i + j], values[i + j + k]);
+                        values[i + j] = low;
+                        values[i + j + k] = high;
+                    }
+}
+
+template<typename T>
+inline T select_rank(T* values, int count, int rank)
+{
+    int low = 0;
+    int high = count - 1;
+    while (low < high) {
+        auto pivot = values[rank];
+        int i = low;
+        int j = high;
+        do {
+            while (values[i] < pivot)
+                ++i;
+            while (pivot < values[j])
+                --j;
+            if (i <= j) {
+                auto swap = values[i];
+                values[i] = values[j];
+                values[j] = swap;
+                ++i;
+                --j;
+            }
+        } while (i <= j);
+
+        if (j < rank)
+            low = i;
+        if (rank < i)
+            high = j;
+    }
+
+    return values[rank];
+}
+
+template<typename T, int N>
+class RankKernel : public WindowKernel<T> {
+    using WindowKernel<T>::m_input;
+    using WindowKernel<T>::m_output;
+    using WindowKernel<T>::map;
+
+private:
+    int m_rank;
+
+public:
+    RankKernel(Image<T>* input, Image<T>* output, Window* window, int rank)
+        : WindowKernel<T>(input, output, window)
+        , m_rank(rank)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        T values[N];
+        int count = 0;
+
+        map(i, [&](auto image_index, auto _) {
+            values[count++] = m_input->data[image_index];
+        });
+
+        if constexpr (N <= RANK_NETWORK_SIZE) {
+            for (int k = count; k < N; ++k)
+                values[k] = VoxelTraits<T>::max;
+            sort_network<T, N>(values);
+            m_output->data[i] = values[m_rank];
+        } else {
+            m_output->data[i] = select_rank(values, count, m_rank);
+        }
+    }
+};
+
+class SlidingRankKernel : public WindowKernel<uint8_t> {
+    using WindowKernel<uint8_t>::m_input;
+    using WindowKernel<uint8_t>::m_output;
+    using WindowKernel<uint8_t>::map;
+
+private:
+    Window* m_leading;
+    Window* m_trailing;
+    int m_rank;
+
+public:
+    SlidingRankKernel(Image<uint8_t>* input, Image<uint8_t>* output, Window* window, Window* leading, Window* trailing, int rank)
+        : WindowKernel<uint8_t>(input, output, window)
+        , m_leading(leading)
+        , m_trailing(trailing)
+        , m_rank(rank)
+    {
+    }
+
+    void operator()(size_t line) const
+    {
+        int length = m_input->shape[1];
+        size_t base = line * length;
+
+        uint16_t histogram[HISTOGRAM_BINS] = {};
+        int level = 0;
+        int below = 0;
+
+        auto add = [&](auto image_index, auto _) {
+            auto value = m_input->data[image_index];
+            ++histogram[value];
+            below += value < level;
+        };
+        auto remove = [&](auto image_index, auto _) {
+            auto value = m_input->data[image_index];
+            --histogram[value];
+            below -= value < level;
+        };
+
+        map(base, add);
+        for (int x = 0; x < length; ++x) {
+            if (x > 0) {
+                map(m_trailing, base + x - 1, remove);
+                map(m_leading, base + x, add);
+            }
+
+            while (below > m_rank)
+                below -= histogram[--level];
+            while (below + histogram[level] <= m_rank)
+                below += histogram[level++];
+
+            m_output->data[base + x] = level;
+        }
+    }
+};
+
+template<typename T>
+class ConvolveKernel : public WindowKernel<T> {
+    using WindowKernel<T>::m_input;
+    using WindowKernel<T>::m_output;
+    using WindowKernel<T>::m_window;
+    using WindowKernel<T>::map;
+
+public:
+    using WindowKernel<T>::WindowKernel;
+
+    void operator()(size_t i) const
+    {
+        float result = 0.0f;
+
+        map(i, [&](auto image_index, auto window_index) {
+            result += m_input->data[image_index] * m_window->data[window_index];
+        });
+
+        m_output->data[i] = static_cast<T>(result);
+    }
+};
+
+using LabelRef = std::atomic_ref<uint32_t>;
+
+inline uint32_t label_find(uint32_t* labels, uint32_t index)
+{
+    for (auto parent = LabelRef(labels[index]).load(std::memory_order_relaxed); parent != index + 1; parent = LabelRef(labels[index]).load(std::memory_order_relaxed))
+        index = parent - 1;
+
+    return index;
+}
+
+inline void label_union(uint32_t* labels, uint32_t a, uint32_t b)
+{
+    while (true) {
+        a = label_find(labels, a);
+        b = label_find(labels, b);
+        if (a == b)
+            return;
+
+        if (a > b)
+            std::swap(a, b);
+
+        auto parent = LabelRef(labels[b]).load(std::memory_order_relaxed);
+        while (a + 1 < parent && !LabelRef(labels[b]).compare_exchange_weak(parent, a + 1, std::memory_order_relaxed))
+            ;
+        if (parent == b + 1)
+            return;
+
+        b = parent - 1;
+    }
+}
+
+template<typename T>
+class LabelInitKernel {
+private:
+    Image<T>* m_input;
+    LabelImage* m_labels;
+
+public:
+    LabelInitKernel(Image<T>* input, LabelImage* labels)
+        : m_input(input)
+        , m_labels(labels)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        m_labels->data[i] = m_input->data[i] != 0 ? uint32_t(i) + 1 : 0;
+    }
+};
+
+template<typename T>
+class LabelMergeKernel : public WindowKernel<T> {
+    using WindowKernel<T>::m_input;
+    using WindowKernel<T>::m_window;
+    using WindowKernel<T>::map;
+
+private:
+    LabelImage* m_labels;
+
+public:
+    LabelMergeKernel(Image<T>* input, LabelImage* labels, Window* window)
+        : WindowKernel<T>(input, nullptr, window)
+        , m_labels(labels)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        if (m_input->data[i] == 0)
+            return;
+
+        map(i, [&](auto image_index, auto window_index) {
+            if (window_index < m_window->size / 2 && m_input->data[image_index] != 0)
+                label_union(m_labels->data, i, image_index);
+        });
+    }
+};
+
+class LabelFlattenKernel {
+private:
+    LabelImage* m_labels;
+
+public:
+    LabelFlattenKernel(LabelImage* labels)
+        : m_labels(labels)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        if (LabelRef(m_labels->data[i]).load(std::memory_order_relaxed) != 0)
+            LabelRef(m_labels->data[i]).store(label_find(m_labels->data, i) + 1, std::memory_order_relaxed);
+    }
+};
+
+template<typename T>
+class DistanceInitKernel {
+private:
+    Image<T>* m_input;
+    Image<float>* m_output;
+
+public:
+    DistanceInitKernel(Image<T>* input, Image<float>* output)
+        : m_input(input)
+        , m_output(output)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        m_output->data[i] = m_input->data[i] != 0 ? DISTANCE_INFINITY : 0.0f;
+    }
+};
+
+class DistanceKernel {
+private:
+    Image<float>* m_input;
+    Image<float>* m_output;
+    int* m_vertex;
+    float* m_boundary;
+    int m_axis;
+
+public:
+    DistanceKernel(Image<float>* input, Image<float>* output, int* vertex, float* boundary, int axis)
+        : m_input(input)
+        , m_output(output)
+        , m_vertex(vertex)
+        , m_boundary(boundary)
+        , m_axis(axis)
+    {
+    }
+
+    void operator()(size_t line) const
+    {
+        size_t stride = m_input->offset[m_axis];
+        int length = m_input->shape[m_axis];
+        size_t base = line / stride * stride * length + line % stride;
+
+        auto f = m_input->data + base;
+        auto v = m_vertex + base;
+        auto z = m_boundary + base;
+
+        int k = 0;
+        v[0] = 0;
+        for (int q = 1; q < length; ++q) {
+            float s;
+            while (true) {
+                int p = v[k * stride];
+                s = ((f[q * stride] + float(q) * q) - (f[p * stride] + float(p) * p)) / (2.0f * (q - p));
+                if (k == 0 || s > z[k * stride])
+                    break;
+                --k;
+            }
+            ++k;
+            v[k * stride] = q;
+            z[k * stride] = s;
+        }
+
+        int last = k;
+        k = 0;
+        for (int q = 0; q < length; ++q) {
+            while (k < last && z[(k + 1) * stride] < q)
+                ++k;
+            int p = v[k * stride];
+            m_output->data[base + q * stride] = float(q - p) * (q - p) + f[p * stride];
+        }
+    }
+};
+
+class DistanceRootKernel {
+private:
+    Image<float>* m_input;
+    Image<float>* m_output;
+
+public:
+    DistanceRootKernel(Image<float>* input, Image<float>* output)
+        : m_input(input)
+        , m_output(output)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        m_output->data[i] = std::sqrt(m_input->data[i]);
+    }
+};
+
+template<typename T>
+class GaussianKernel {
+private:
+    Image<T>* m_input;
+    Image<float>* m_output;
+    GaussianCoefficients m_coefficients;
+    int m_axis;
+
+public:
+    GaussianKernel(Image<T>* input, Image<float>* output, GaussianCoefficients coefficients, int axis)
+        : m_input(input)
+        , m_output(output)
+        , m_coefficients(coefficients)
+        , m_axis(axis)
+    {
+    }
+
+    void operator()(size_t line) const
+    {
+        size_t stride = m_input->offset[m_axis];
+        int length = m_input->shape[m_axis];
+        size_t base = line / stride * stride * length + line % stride;
+
+        auto x = m_input->data + base;
+        auto y = m_output->data + base;
+        auto [b, a1, a2, a3] = m_coefficients;
+
+        float w1 = x[0];
+        float w2 = w1;
+        float w3 = w1;
+        for (int n = 0; n < length; ++n) {
+            float w = b * x[n * stride] + a1 * w1 + a2 * w2 + a3 * w3;
+            y[n * stride] = w;
+            w3 = w2;
+            w2 = w1;
+            w1 = w;
+        }
+
+        w2 = w1;
+        w3 = w1;
+        for (int n = length - 1; n >= 0; --n) {
+            float w = b * y[n * stride] + a1 * w1 + a2 * w2 + a3 * w3;
+            y[n * stride] = w;
+            w3 = w2;
+            w2 = w1;
+            w1 = w;
+        }
+    }
+};
+
+template<typename T>
+class RoundKernel {
+private:
+    Image<float>* m_input;
+    Image<T>* m_output;
+
+public:
+    RoundKernel(Image<float>* input, Image<T>* output)
+        : m_input(input)
+        , m_output(output)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        if constexpr (std::is_floating_point_v<T>)
+            m_output->data[i] = m_input->data[i];
+        else
+            m_output->data[i] = T(std::clamp(m_input->data[i] + 0.5f, 0.0f, float(VoxelTraits<T>::max)));
+    }
+};
+
+template<typename T>
+class FftLoadKernel {
+private:
+    Image<T>* m_input;
+    FftPlan* m_plan;
+    float* m_data;
+    size_t m_first;
+
+public:
+    FftLoadKernel(Image<T>* input, FftPlan* plan, float* data, size_t first)
+        : m_input(input)
+        , m_plan(plan)
+        , m_data(data)
+        , m_first(first)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        size_t pair = m_first + i / m_plan->size;
+
+        for (size_t part = 0; part < 2; ++part) {
+            size_t tile = 2 * pair + part;
+            if (tile >= m_plan->tiles) {
+                m_data[2 * i + part] = 0.0f;
+                continue;
+            }
+
+            size_t tile_rest = tile;
+            size_t voxel_rest = i % m_plan->size;
+            size_t index = 0;
+            for (int d = 1; d <= m_plan->dimensions; ++d) {
+                int origin = tile_rest % m_plan->grid[d] * m_plan->valid[d];
+                int coord = origin - m_plan->anchor[d] + voxel_rest % m_plan->shape[d];
+                tile_rest /= m_plan->grid[d];
+                voxel_rest /= m_plan->shape[d];
+                index += m_input->offset[d] * std::clamp(coord, 0, m_input->shape[d] - 1);
+            }
+
+            m_data[2 * i + part] = m_input->data[index];
+        }
+    }
+};
+
+class FftKernel {
+private:
+    FftPlan* m_plan;
+    float* m_data;
+    float* m_scratch;
+    int m_axis;
+    bool m_inverse;
+
+public:
+    FftKernel(FftPlan* plan, float* data, float* scratch, int axis, bool inverse)
+        : m_plan(plan)
+        , m_data(data)
+        , m_scratch(scratch)
+        , m_axis(axis)
+        , m_inverse(inverse)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        size_t stride = m_plan->offset[m_axis];
+        int length = m_plan->shape[m_axis];
+        size_t lines = m_plan->size / length;
+        size_t line = i % lines;
+        size_t base = i / lines * m_plan->size + line / stride * stride * length + line % stride;
+
+        auto radices = m_plan->radices + m_plan->radix_offset[m_axis];
+        auto radix_count = m_plan->radix_offset[m_axis + 1] - m_plan->radix_offset[m_axis];
+        auto twiddles = m_plan->twiddles + 2 * m_plan->twiddle_offset[m_axis];
+        fft_line(m_data + 2 * base, m_scratch + 2 * base, stride, length, radices, radix_count, twiddles, m_inverse);
+    }
+};
+
+class FftMultiplyKernel {
+private:
+    FftPlan* m_plan;
+    float* m_data;
+
+public:
+    FftMultiplyKernel(FftPlan* plan, float* data)
+        : m_plan(plan)
+        , m_data(data)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        size_t frequency = i % m_plan->size;
+        float real = m_data[2 * i];
+        float imag = m_data[2 * i + 1];
+        float spectrum_real = m_plan->spectrum[2 * frequency];
+        float spectrum_imag = m_plan->spectrum[2 * frequency + 1];
+        m_data[2 * i] = real * spectrum_real - imag * spectrum_imag;
+        m_data[2 * i + 1] = real * spectrum_imag + imag * spectrum_real;
+    }
+};
+
+template<typename T>
+class FftStoreKernel {
+private:
+    float* m_data;
+    FftPlan* m_plan;
+    Image<T>* m_output;
+    size_t m_first;
+
+public:
+    FftStoreKernel(float* data, FftPlan* plan, Image<T>* output, size_t first)
+        : m_data(data)
+        , m_plan(plan)
+        , m_output(output)
+        , m_first(first)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        size_t pair = m_first + i / m_plan->size;
+
+        for (size_t part = 0; part < 2; ++part) {
+            size_t tile = 2 * pair + part;
+            if (tile >= m_plan->tiles)
+                continue;
+
+            size_t tile_rest = tile;
+            size_t voxel_rest = i % m_plan->size;
+            size_t index = 0;
+            bool inside = true;
+            for (int d = 1; d <= m_plan->dimensions; ++d) {
+                int voxel = voxel_rest % m_plan->shape[d];
+                int coord = tile_rest % m_plan->grid[d] * m_plan->valid[d] + voxel;
+                tile_rest /= m_plan->grid[d];
+                voxel_rest /= m_plan->shape[d];
+                inside = inside && voxel < m_plan->valid[d] && coord < m_output->shape[d];
+                index += m_output->offset[d] * coord;
+            }
+
+            if (inside)
+                m_output->data[index] = static_cast<T>(m_data[2 * i + part]);
+        }
+    }
+};
+
+template<typename T>
+inline size_t bricked_position(BrickedImage<T>* image, int const* coord)
+{
+    size_t position = 0;
+    for (int d = 1; d <= image->dimensions; ++d)
+        position += image->table[image->table_offset[d] + coord[d]];
+
+    return position;
+}
+
+template<typename T>
+inline void bricked_coord(BrickedImage<T>* image, size_t index, int* coord)
+{
+    int ires = index;
+    for (int d = image->dimensions; d >= 1; --d) {
+        coord[d] = ires / image->offset[d];
+        ires = ires - coord[d] * image->offset[d];
+    }
+}
+
+template<typename T>
+class ToBrickedKernel {
+private:
+    Image<T>* m_input;
+    BrickedImage<T>* m_output;
+
+public:
+    ToBrickedKernel(Image<T>* input, BrickedImage<T>* output)
+        : m_input(input)
+        , m_output(output)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        int coord[VGL_ARR_SHAPE_SIZE];
+        bricked_coord(m_output, i, coord);
+        m_output->data[bricked_position(m_output, coord)] = m_input->data[i];
+    }
+};
+
+template<typename T>
+class FromBrickedKernel {
+private:
+    BrickedImage<T>* m_input;
+    Image<T>* m_output;
+
+public:
+    FromBrickedKernel(BrickedImage<T>* input, Image<T>* output)
+        : m_input(input)
+        , m_output(output)
+    {
+    }
+
+    void operator()(size_t i) const
+    {
+        int coord[VGL_ARR_SHAPE_SIZE];
+        bricked_coord(m_input, i, coord);
+        m_output->data[i] = m_input->data[bricked_position(m_input, coord)];
+    }
+};
+
+template<typename T>
+class BrickedWindowKernel {
+protected:
+    BrickedImage<T>* m_input;
+    BrickedImage<T>* m_output;
+    Window* m_window;
+
+public:
+    BrickedWindowKernel(BrickedImage<T>* input, BrickedImage<T>* output, Window* window)
+        : m_input(input)
+        , m_output(output)
+        , m_window(window)
+    {
+    }
+
+    template<typename Func = std::function<void(size_t, size_t)>>
+    inline size_t map(size_t index, Func&& apply) const
+    {
+        int image_coord[VGL_ARR_SHAPE_SIZE];
+        int window_coord[VGL_ARR_SHAPE_SIZE];
+        bricked_coord(m_input, index, image_coord);
+
+        for (size_t window_index = 0; window_index < m_window->size; ++window_index) {
+            if (m_window->data[window_index] == 0)
+                continue;
+
+            int ires = window_index;
+            for (int d = m_window->dimensions; d >= 1; --d) {
+                int off = m_window->offset[d];
+                int idim = ires / off;
+                ires = ires - idim * off;
+                window_coord[d] = std::clamp(image_coord[d] + idim - (m_window->shape[d] - 1) / 2, 0, m_input->shape[d] - 1);
+            }
+
+            apply(bricked_position(m_input, window_coord), window_index);
+        }
+
+        return bricked_position(m_output, image_coord);
+    }
+};
+
+template<typename T>
+class BrickedErodeKernel : public BrickedWindowKernel<T> {
+    using BrickedWindowKernel<T>::m_input;
+    using BrickedWindowKernel<T>::m_output;
+    using BrickedWindowKernel<T>::map;
+
+public:
+    using BrickedWindowKernel<T>::BrickedWindowKernel;
+
+    void operator()(size_t i) const
+    {
+        T pmin = VoxelTraits<T>::max;
+
+        auto position = map(i, [&](auto image_index, auto _) {
+            pmin = std::min(pmin, m_input->data[image_index]);
+        });
+
+        m_output->data[position] = pmin;
+    }
+};
+
+template<typename T>
+class BrickedConvolveKernel : public BrickedWindowKernel<T> {
+    using BrickedWindowKernel<T>::m_input;
+    using BrickedWindowKernel<T>::m_output;
+    using BrickedWindowKernel<T>::m_window;
+    using BrickedWindowKernel<T>::map;
+
+public:
+    using BrickedWindowKernel<T>::BrickedWindowKernel;
+
+    void operator()(size_t i) const
+    {
+        float result = 0.0f;
+
+        auto position = map(i, [&](auto image_index, auto window_index) {
+            result += m_input->data[image_index] * m_window->data[window_index];
+        });
+
+        m_output->data[position] = static_cast<T>(result);
+    }
+};
+
+// Each thread counts into a private copy of the histogram, copies are summed when the loop ends
+template<typename T>
+void image_histogram(Image<T>* input, uint32_t* histogram)
+{
+    std::fill_n(histogram, HISTOGRAM_BINS, 0);
+
+#pragma omp parallel for schedule(static) reduction(+ : histogram[:HISTOGRAM_BINS])
+    for (size_t i = 0; i < input->size; ++i)
+        histogram[voxel_bin(input->data[i])] += 1;
+}
+
+template<typename T>
+void image_statistics(Image<T>* input, Statistics<T>* statistics)
+{
+    T min = VoxelTraits<T>::max;
+    T max = 0;
+    double sum = 0;
+
+#pragma omp parallel for schedule(static) reduction(min : min) reduction(max : max) reduction(+ : sum)
+    for (size_t i = 0; i < input->size; ++i) {
+        auto value = input->data[i];
+        min = std::min(min, value);
+        max = std::max(max, value);
+        sum += value;
+    }
+
+    statistics->min = min;
+    statistics->max = max;
+    statistics->sum = sum;
+    statistics->mean = sum / input->size;
+}
+
+// First written with the static partition of every kernel, so that pages land on the node of their thread
+template<typename T, typename U>
+Image<T>* image_local_similar_from_image(Image<U>* image)
+{
+    auto similar = new Image<T>();
+
+    similar->data = new T[image->size];
+    similar->shape = new int[image->dimensions + 1];
+    similar->offset = new int[image->dimensions + 1];
+    similar->dimensions = image->dimensions;
+    similar->size = image->size;
+
+    std::copy_n(image->shape, image->dimensions + 1, similar->shape);
+    std::copy_n(image->offset, image->dimensions + 1, similar->offset);
+    parallel_for(similar->size, FillKernel<T>(similar, T()));
+
+    return similar;
+}
+
+template<typename T, typename U>
+Image<T>* image_local_cast(Image<U>* image)
+{
+    auto cast = image_local_similar_from_image<T>(image);
+
+    parallel_for(cast->size, [&](size_t i) { cast->data[i] = voxel_from_uint8<T>(voxel_to_uint8<U>(image->data[i])); });
+
+    return cast;
+}
+
+template<typename T>
+BenchmarkSession benchmark_voxel(Image<uint8_t>* source, VglImage* vglimage, size_t rounds, std::function<void(VglImage*, std::string)> save_image, bool header)
+{
+    auto input = image_local_cast<T>(source);
+    auto output = image_local_similar_from_image<T>(input);
+    auto temp = image_local_similar_from_image<T>(input);
+    auto dimensions = input->dimensions;
+
+    auto const suffix = std::is_same_v<T, uint8_t> ? std::string() : std::string("-") + VoxelTraits<T>::name;
+    auto const threshold = voxel_from_uint8<T>(128);
+    auto const max_value = VoxelTraits<T>::max;
+
+    auto cross_window = window_create_from_type(WindowType::CROSS, dimensions);
+    auto cube_window = window_create_from_type(WindowType::CUBE, dimensions);
+    auto const cross_count = window_count(cross_window);
+    auto const cube_count = window_count(cube_window);
+    auto cross_leading_window = window_create_edge_from_window(cross_window, 1, 1);
+    auto cross_trailing_window = window_create_edge_from_window(cross_window, 1, -1);
+    auto cube_leading_window = window_create_edge_from_window(cube_window, 1, 1);
+    auto cube_trailing_window = window_create_edge_from_window(cube_window, 1, -1);
+    auto mean_window = window_create_from_type(WindowType::MEAN, dimensions);
+
+    auto cube_window_array = new Window*[dimensions + 1];
+    auto mean_window_array = new Window*[dimensions + 1];
+    for (int i = 1; i <= dimensions; ++i) {
+        cube_window_array[i] = window_create_axis_from_type(WindowType::CUBE, dimensions, i);
+        mean_window_array[i] = window_create_axis_from_type(WindowType::MEAN, dimensions, i);
+    }
+
+    uint32_t histogram[HISTOGRAM_BINS];
+    auto statistics = Statistics<T>();
+
+    auto labels = image_local_similar_from_image<uint32_t>(input);
+    auto mask = image_local_similar_from_image<T>(input);
+    parallel_for(input->size, ThresholdKernel<T>(input, mask, threshold, max_value));
+
+    auto distances = image_local_cast<float>(input);
+    auto distances_temp = image_local_similar_from_image<float>(distances);
+    auto distance_vertex = new int[input->size];
+    auto distance_boundary = new float[input->size];
+
+    auto blur = image_local_similar_from_image<float>(distances);
+    auto blur_temp = image_local_similar_from_image<float>(distances);
+
+    auto const gaussian_sigmas = std::vector<int> { 1, 2, 5, 10, 20 };
+    auto gaussian_window_array = std::vector<Window*>(gaussian_sigmas.size() * (dimensions + 1));
+    for (size_t s = 0; s < gaussian_sigmas.size(); ++s)
+        for (int i = 1; i <= dimensions; ++i)
+            gaussian_window_array[s * (dimensions + 1) + i] = window_create_gaussian_axis(gaussian_sigmas[s], dimensions, i);
+
+    auto gaussian = [&](GaussianCoefficients coefficients) {
+        parallel_for(input->size / input->shape[1], GaussianKernel<T>(input, blur, coefficients, 1));
+        for (int i = 2; i <= dimensions; ++i)
+            if (i & 0b1)
+                parallel_for(input->size / input->shape[i], GaussianKernel<float>(blur_temp, blur, coefficients, i));
+            else
+                parallel_for(input->size / input->shape[i], GaussianKernel<float>(blur, blur_temp, coefficients, i));
+        parallel_for(input->size, RoundKernel<T>(dimensions & 0b1 ? blur : blur_temp, output));
+    };
+
+    auto select_filter = [&](Window* window, size_t count, int rank) {
+        if (count <= RANK_WINDOW_SIZES[0])
+            parallel_for(input->size, RankKernel<T, RANK_WINDOW_SIZES[0]>(input, output, window, rank));
+        else if (count <= RANK_WINDOW_SIZES[1])
+            parallel_for(input->size, RankKernel<T, RANK_WINDOW_SIZES[1]>(input, output, window, rank));
+        else
+            parallel_for(input->size, RankKernel<T, RANK_WINDOW_SIZES[2]>(input, output, window, rank));
+    };
+
+    auto rank_filter = [&](Window* window, Window* leading, Window* trailing, size_t count, int rank) {
+        if (count <= RANK_NETWORK_SIZE)
+            parallel_for(input->size, RankKernel<T, RANK_NETWORK_SIZE>(input, output, window, rank));
+        else if constexpr (std::is_same_v<T, uint8_t>)
+            parallel_for(input->size / input->shape[1], SlidingRankKernel(input, output, window, leading, trailing, rank));
+        else
+            select_filter(window, count, rank);
+    };
+
+    struct Strel {
+        std::string name;
+        StrelPlan* plan;
+    };
+
+    auto strels = std::vector<Strel>();
+    auto const strel_types = { std::pair(StrelType::BALL, "ball"), std::pair(StrelType::DIAMOND, "diamond"), std::pair(StrelType::ELLIPSOID, "ellipsoid") };
+    if (dimensions <= 3)
+        for (auto [type, name] : strel_types)
+            for (int radius : { 3, 7, 15 }) {
+                int radii[VGL_ARR_SHAPE_SIZE];
+                for (int d = 1; d <= dimensions; ++d)
+                    radii[d] = radius;
+                if (type == StrelType::ELLIPSOID)
+                    radii[dimensions] = (radius + 1) / 2;
+
+                strels.push_back({ std::string(name) + "-r" + std::to_string(radius), strel_plan_create(type, radii, dimensions) });
+            }
+    auto reference = image_local_similar_from_image<T>(input);
+
+    auto strel_erode = [&](StrelPlan* plan) {
+        if (plan->steps.empty()) {
+            parallel_for(input->size, ErodeKernel<T>(input, output, plan->window));
+            return;
+        }
+
+        auto source = input;
+        for (size_t s = 0; s < plan->steps.size(); ++s) {
+            auto target = (plan->steps.size() - s) & 0b1 ? output : temp;
+            parallel_for(input->size, ErodeKernel<T>(source, target, plan->steps[s]));
+            source = target;
+        }
+    };
+
+    struct Psf {
+        std::string name;
+        FftPlan* plan;
+        Window* window;
+        bool preferred;
+        bool direct;
+    };
+
+    auto psfs = std::vector<Psf>();
+    size_t fft_capacity = 0;
+    for (int sigma : dimensions <= 3 ? std::vector { 1, 2, 5 } : std::vector { 1, 2 }) {
+        auto window = window_create_gaussian(sigma, dimensions);
+        auto plan = fft_plan_create(input->shape, dimensions, window);
+        auto name = "psf-s" + std::to_string(sigma);
+        auto preferred = fft_plan_preferred(plan, window, input->size);
+        std::cerr << name << suffix << ": " << plan->tiles << " tiles of " << plan->size << " voxels, "
+                  << (preferred ? "transform" : "direct window") << " preferred" << std::endl;
+        auto direct = dimensions <= 3 || sigma == 1;
+        psfs.push_back({ name, plan, window, preferred, direct });
+        fft_capacity = std::max(fft_capacity, plan->batch * plan->size);
+    }
+    auto fft_data = new float[2 * fft_capacity];
+    auto fft_scratch = new float[2 * fft_capacity];
+
+    auto fft_convolve = [&](Psf const& psf) {
+        auto plan = psf.plan;
+        for (size_t first = 0; first < plan->pairs; first += plan->batch) {
+            auto size = std::min(plan->batch, plan->pairs - first) * plan->size;
+            parallel_for(size, FftLoadKernel<T>(input, psf.plan, fft_data, first));
+            for (int i = 1; i <= dimensions; ++i)
+                parallel_for(size / plan->shape[i], FftKernel(psf.plan, fft_data, fft_scratch, i, false));
+            parallel_for(size, FftMultiplyKernel(psf.plan, fft_data));
+            for (int i = 1; i <= dimensions; ++i)
+                parallel_for(size / plan->shape[i], FftKernel(psf.plan, fft_data, fft_scratch, i, true));
+            parallel_for(size, FftStoreKernel<T>(fft_data, psf.plan, output, first));
+        }
+    };
+
+    struct Operator {
+        PipelineStep step;
+        std::function<void(Image<T>*, Image<T>*)> func;
+    };
+
+    auto chain = std::vector<Operator>();
+    chain.push_back({
+        .step = { 0, 1, true },
+        .func = [&](Image<T>* source, Image<T>* target) { parallel_for(input->size, ThresholdKernel<T>(source, target, threshold, max_value)); },
+    });
+    for (int i = 1; i <= dimensions; ++i)
+        chain.push_back({
+            .step = { int(chain.size()), int(chain.size()) + 1, false },
+            .func = [&, i](Image<T>* source, Image<T>* target) { parallel_for(input->size, ErodeKernel<T>(source, target, cube_window_array[i])); },
+        });
+    chain.push_back({
+        .step = { int(chain.size()), int(chain.size()) + 1, true },
+        .func = [&](Image<T>* source, Image<T>* target) { parallel_for(input->size, InvertKernel<T>(source, target)); },
+    });
+    for (int i = 1; i <= dimensions; ++i)
+        chain.push_back({
+            .step = { int(chain.size()), int(chain.size()) + 1, false },
+            .func = [&, i](Image<T>* source, Image<T>* target) { parallel_for(input->size, ConvolveKernel<T>(source, target, mean_window_array[i])); },
+        });
+
+    auto pipeline_steps = std::vector<PipelineStep>();
+    for (auto const& op : chain)
+        pipeline_steps.push_back(op.step);
+    auto pipeline = pipeline_plan_create(pipeline_steps);
+    memory_reset_peak();
+    auto pipeline_live = memory_usage().host.live;
+    auto pipeline_buffers = std::vector<Image<T>*> { input };
+    for (int b = 1; b < pipeline->count; ++b)
+        pipeline_buffers.push_back(image_local_similar_from_image<T>(input));
+    auto pipeline_measured = memory_usage().host.peak - pipeline_live + input->size * sizeof(T);
+
+    std::cerr << "threshold-erode-invert-convolve" << suffix << ": " << pipeline->count << " buffers ("
+              << pipeline->count * input->size * sizeof(T) << " bytes) planned, " << pipeline_measured << " bytes measured, "
+              << chain.size() + 1 << " buffers (" << (chain.size() + 1) * input->size * sizeof(T) << " bytes) naive" << std::endl;
+
+    struct Batch {
+        int count;
+        Image<T>* input;
+        Image<T>* output;
+        std::vector<Image<T>> input_volumes;
+        std::vector<Image<T>> output_volumes;
+    };
+
+    auto batch_cube_window = window_batch_from_window(cube_window, 1);
+    auto batch_mean_window = window_batch_from_window(mean_window, 1);
+
+    // Volumes share the data, shape and offset of their batch
+    auto batches = std::vector<Batch>();
+    for (int count = 1; count <= 1024; count *= 4) {
+        auto batch = Batch { count, image_batch_from_image(input, batch_volume_edge(dimensions), count) };
+        batch.output = image_similar_from_image(batch.input);
+        size_t volume_size = batch.input->offset[batch.input->dimensions];
+        for (int b = 0; b < count; ++b) {
+            batch.input_volumes.push_back({ batch.input->data + b * volume_size, batch.input->shape, batch.input->offset, dimensions, volume_size });
+            batch.output_volumes.push_back({ batch.output->data + b * volume_size, batch.output->shape, batch.output->offset, dimensions, volume_size });
+        }
+        batches.push_back(batch);
+    }
+
+    auto volume_cube_window = (Window*)nullptr;
+    auto axes_cube_window = (Window*)nullptr;
+    auto axes_input_volumes = std::vector<Image<T>>();
+    auto axes_output_volumes = std::vector<Image<T>>();
+    if (dimensions == 5) {
+        volume_cube_window = window_create_from_type(WindowType::CUBE, 3);
+        axes_cube_window = window_batch_from_window(volume_cube_window, 2);
+
+        size_t volume_size = input->offset[4];
+        for (int b = 0; b < input->shape[4] * input->shape[5]; ++b) {
+            axes_input_volumes.push_back({ input->data + b * volume_size, input->shape, input->offset, 3, volume_size });
+            axes_output_volumes.push_back({ temp->data + b * volume_size, temp->shape, temp->offset, 3, volume_size });
+        }
+    }
+
+    struct Layout {
+        std::string name;
+        BrickedImage<T>* input;
+        BrickedImage<T>* output;
+        BrickedImage<T>* temp;
+    };
+
+    auto layouts = std::vector<Layout>();
+    for (auto [order, name] : { std::pair(BrickOrder::ROW_MAJOR, "bricked"), std::pair(BrickOrder::MORTON, "morton") }) {
+        auto bricked_input = bricked_image_similar_from_image(input, order);
+        std::cerr << name << suffix << ": " << bricked_input->capacity << " voxels padded from " << input->size << std::endl;
+        parallel_for(input->size, ToBrickedKernel<T>(input, bricked_input));
+        layouts.push_back({ name, bricked_input, bricked_image_similar_from_image(input, order), bricked_image_similar_from_image(input, order) });
+    }
+
+    auto label = [&](Window* window) {
+        parallel_for(input->size, LabelInitKernel<T>(mask, labels));
+        parallel_for(input->size, LabelMergeKernel<T>(mask, labels, window));
+        parallel_for(input->size, LabelFlattenKernel(labels));
+    };
+
+    auto save_sample = [&](std::string name) {
+        image_to_vglimage(output, vglimage);
+        save_image(vglimage, name);
+    };
+
+    auto save_distance_sample = [&](std::string name) {
+        distance_image_to_vglimage(distances, vglimage);
+        save_image(vglimage, name);
+    };
+
+    auto save_label_sample = [&](std::string name) {
+        label_image_to_vglimage(labels, vglimage);
+        save_image(vglimage, name);
+    };
+
+    auto builder = BenchmarkBuilder();
+    builder.attach({
+        .name = "copy" + suffix,
+        .type = "group",
+        .group = "memory",
+        .post = save_sample,
+        .func = [&] { parallel_for(input->size, [&](size_t i) { output->data[i] = input->data[i]; }); },
+    });
+    builder.attach({
+        .name = "invert" + suffix,
+        .type = "group",
+        .group = "point",
+        .post = save_sample,
+        .func = [&] { parallel_for(input->size, InvertKernel<T>(input, output)); },
+    });
+    builder.attach({
+        .name = "threshold" + suffix,
+        .type = "group",
+        .group = "point",
+        .post = save_sample,
+        .func = [&] { parallel_for(input->size, ThresholdKernel<T>(input, output, threshold, max_value)); },
+    });
+    builder.attach({
+        .name = "histogram" + suffix,
+        .type = "group",
+        .group = "reduction",
+        .func = [&] { image_histogram(input, histogram); },
+    });
+    builder.attach({
+        .name = "statistics" + suffix,
+        .type = "group",
+        .group = "reduction",
+        .func = [&] { image_statistics(input, &statistics); },
+    });
+    builder.attach({
+        .name = "otsu-threshold" + suffix,
+        .type = "group",
+        .group = "reduction",
+        .post = save_sample,
+        .func = [&] {
+            image_histogram(input, histogram);
+            auto level = voxel_from_bin<T>(otsu_threshold(histogram));
+            parallel_for(input->size, ThresholdKernel<T>(input, output, level, max_value));
+        },
+    });
+    builder.attach({
+        .name = "erode-cross" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] { parallel_for(input->size, ErodeKernel<T>(input, output, cross_window)); },
+    });
+    builder.attach({
+        .name = "erode-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] { parallel_for(input->size, ErodeKernel<T>(input, output, cube_window)); },
+    });
+    builder.attach({
+        .name = "split-erode-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            parallel_for(input->size, ErodeKernel<T>(input, temp, cube_window_array[1]));
+            for (int i = 2; i <= dimensions; ++i)
+                if (i & 0b1)
+                    parallel_for(input->size, ErodeKernel<T>(output, temp, cube_window_array[i]));
+                else
+                    parallel_for(input->size, ErodeKernel<T>(temp, output, cube_window_array[i]));
+            if (dimensions & 0b1)
+                parallel_for(input->size, [&](size_t i) { output->data[i] = temp->data[i]; });
+        },
+    });
+    builder.attach({
+        .name = "distance-transform" + suffix,
+        .type = "single",
+        .post = save_distance_sample,
+        .func = [&] {
+            parallel_for(input->size, DistanceInitKernel<T>(mask, distances));
+            for (int i = 1; i <= dimensions; ++i)
+                if (i & 0b1)
+                    parallel_for(input->size / input->shape[i], DistanceKernel(distances, distances_temp, distance_vertex, distance_boundary, i));
+                else
+                    parallel_for(input->size / input->shape[i], DistanceKernel(distances_temp, distances, distance_vertex, distance_boundary, i));
+            parallel_for(input->size, DistanceRootKernel(dimensions & 0b1 ? distances_temp : distances, distances));
+        },
+    });
+    builder.attach({
+        .name = "convolve" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] { parallel_for(input->size, ConvolveKernel<T>(input, output, mean_window)); },
+    });
+    builder.attach({
+        .name = "split-convolve" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            parallel_for(input->size, ConvolveKernel<T>(input, temp, mean_window_array[1]));
+            for (int i = 2; i <= dimensions; ++i)
+                if (i & 0b1)
+                    parallel_for(input->size, ConvolveKernel<T>(output, temp, mean_window_array[i]));
+                else
+                    parallel_for(input->size, ConvolveKernel<T>(temp, output, mean_window_array[i]));
+            if (dimensions & 0b1)
+                parallel_for(input->size, [&](size_t i) { output->data[i] = temp->data[i]; });
+        },
+    });
+    for (size_t s = 0; s < gaussian_sigmas.size(); ++s) {
+        auto const sigma = "-sigma" + std::to_string(gaussian_sigmas[s]);
+        auto const coefficients = gaussian_coefficients(gaussian_sigmas[s]);
+        auto const window_array = gaussian_window_array.data() + s * (dimensions + 1);
+        builder.attach({
+            .name = "gaussian" + sigma + suffix,
+            .type = "single",
+            .post = save_sample,
+            .func = [&, coefficients] { gaussian(coefficients); },
+        });
+        builder.attach({
+            .name = "split-convolve-gaussian" + sigma + suffix,
+            .type = "single",
+            .post = save_sample,
+            .func = [&, window_array] {
+                parallel_for(input->size, ConvolveKernel<T>(input, temp, window_array[1]));
+                for (int i = 2; i <= dimensions; ++i)
+                    if (i & 0b1)
+                        parallel_for(input->size, ConvolveKernel<T>(output, temp, window_array[i]));
+                    else
+                        parallel_for(input->size, ConvolveKernel<T>(temp, output, window_array[i]));
+                if (dimensions & 0b1)
+                    parallel_for(input->size, [&](size_t i) { output->data[i] = temp->data[i]; });
+            },
+        });
+    }
+    builder.attach({
+        .name = "threshold-erode-invert-convolve" + suffix,
+        .type = "single",
+        .post = [&](std::string name) {
+            std::copy_n(pipeline_buffers[pipeline->buffers.back()]->data, input->size, output->data);
+            save_sample(name);
+        },
+        .func = [&] {
+            for (auto const& op : chain)
+                op.func(pipeline_buffers[pipeline->buffers[op.step.input]], pipeline_buffers[pipeline->buffers[op.step.output]]);
+        },
+    });
+    builder.attach({
+        .name = "median-cross" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] { rank_filter(cross_window, cross_leading_window, cross_trailing_window, cross_count, cross_count / 2); },
+    });
+    builder.attach({
+        .name = "median-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] { rank_filter(cube_window, cube_leading_window, cube_trailing_window, cube_count, cube_count / 2); },
+    });
+    builder.attach({
+        .name = "naive-median-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] { select_filter(cube_window, cube_count, cube_count / 2); },
+    });
+    builder.attach({
+        .name = "percentile90-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] { rank_filter(cube_window, cube_leading_window, cube_trailing_window, cube_count, rank_from_percentile(90, cube_count)); },
+    });
+    for (auto const& strel : strels) {
+        builder.attach({
+            .name = "erode-" + strel.name + suffix,
+            .type = "single",
+            .post = [&](std::string name) {
+                save_sample(name);
+                parallel_for(input->size, ErodeKernel<T>(input, reference, strel.plan->window));
+                auto mismatches = std::inner_product(output->data, output->data + output->size, reference->data, size_t(0), std::plus<>(), std::not_equal_to<>());
+                std::cerr << name << ": " << strel.plan->steps.size() << " passes, " << mismatches << " voxels differ from the direct window\n";
+            },
+            .func = [&] { strel_erode(strel.plan); },
+        });
+        builder.attach({
+            .name = "direct-erode-" + strel.name + suffix,
+            .type = "single",
+            .post = save_sample,
+            .func = [&] { parallel_for(input->size, ErodeKernel<T>(input, output, strel.plan->window)); },
+        });
+    }
+    for (auto const& psf : psfs) {
+        if (psf.direct)
+            builder.attach({
+                .name = "convolve-" + psf.name + suffix,
+                .type = "single",
+                .post = save_sample,
+                .func = [&] { parallel_for(input->size, ConvolveKernel<T>(input, output, psf.window)); },
+            });
+        builder.attach({
+            .name = "fft-convolve-" + psf.name + suffix,
+            .type = "single",
+            .post = [&](std::string name) {
+                save_sample(name);
+                if (!psf.direct)
+                    return;
+                auto max = [](float a, float b) { return std::max(a, b); };
+                auto distance = [](T a, T b) { return std::abs(float(a) - float(b)); };
+                parallel_for(input->size, ConvolveKernel<T>(input, reference, psf.window));
+                auto difference = std::inner_product(output->data, output->data + output->size, reference->data, 0.0f, max, distance);
+                std::cerr << name << ": " << psf.plan->tiles << " tiles, " << difference << " largest difference from the direct window\n";
+            },
+            .func = [&] { fft_convolve(psf); },
+        });
+        builder.attach({
+            .name = "auto-convolve-" + psf.name + suffix,
+            .type = "single",
+            .post = save_sample,
+            .func = [&] {
+                if (psf.preferred)
+                    fft_convolve(psf);
+                else
+                    parallel_for(input->size, ConvolveKernel<T>(input, output, psf.window));
+            },
+        });
+    }
+    for (auto& batch : batches) {
+        auto const count = "-" + std::to_string(batch.count);
+
+        builder.attach({
+            .name = "batched-erode-cube" + count + suffix,
+            .type = "group",
+            .group = "batch",
+            .func = [&] { parallel_for(batch.input->size, ErodeKernel<T>(batch.input, batch.output, batch_cube_window)); },
+        });
+        builder.attach({
+            .name = "looped-erode-cube" + count + suffix,
+            .type = "group",
+            .group = "batch",
+            .func = [&] {
+                for (int b = 0; b < batch.count; ++b)
+                    parallel_for(batch.input_volumes[b].size, ErodeKernel<T>(&batch.input_volumes[b], &batch.output_volumes[b], cube_window));
+            },
+        });
+        builder.attach({
+            .name = "batched-convolve" + count + suffix,
+            .type = "group",
+            .group = "batch",
+            .func = [&] { parallel_for(batch.input->size, ConvolveKernel<T>(batch.input, batch.output, batch_mean_window)); },
+        });
+        builder.attach({
+            .name = "looped-convolve" + count + suffix,
+            .type = "group",
+            .group = "batch",
+            .func = [&] {
+                for (int b = 0; b < batch.count; ++b)
+                    parallel_for(batch.input_volumes[b].size, ConvolveKernel<T>(&batch.input_volumes[b], &batch.output_volumes[b], mean_window));
+            },
+        });
+    }
+    if (dimensions == 5) {
+        auto axes_looped_erode = [&] {
+            for (size_t b = 0; b < axes_input_volumes.size(); ++b)
+                parallel_for(axes_input_volumes[b].size, ErodeKernel<T>(&axes_input_volumes[b], &axes_output_volumes[b], volume_cube_window));
+        };
+
+        builder.attach({
+            .name = "batched-erode-cube-axes" + suffix,
+            .type = "group",
+            .group = "batch",
+            .post = [&, axes_looped_erode](std::string name) {
+                axes_looped_erode();
+                auto mismatches = std::inner_product(output->data, output->data + output->size, temp->data, size_t(0), std::plus<>(), std::not_equal_to<>());
+                std::cerr << name << ": " << axes_input_volumes.size() << " volumes, " << mismatches << " voxels differ from the looped volumes\n";
+            },
+            .func = [&] { parallel_for(input->size, ErodeKernel<T>(input, output, axes_cube_window)); },
+        });
+        builder.attach({
+            .name = "looped-erode-cube-axes" + suffix,
+            .type = "group",
+            .group = "batch",
+            .func = axes_looped_erode,
+        });
+    }
+    for (auto const& layout : layouts) {
+        auto const prefix = layout.name + "-";
+        auto save_bricked_sample = [&](std::string name) {
+            parallel_for(input->size, FromBrickedKernel<T>(layout.output, output));
+            save_sample(name);
+        };
+
+        builder.attach({
+            .name = "to-" + layout.name + suffix,
+            .type = "group",
+            .group = "layout",
+            .func = [&] { parallel_for(input->size, ToBrickedKernel<T>(input, layout.output)); },
+        });
+        builder.attach({
+            .name = "from-" + layout.name + suffix,
+            .type = "group",
+            .group = "layout",
+            .func = [&] { parallel_for(input->size, FromBrickedKernel<T>(layout.input, output)); },
+        });
+        builder.attach({
+            .name = prefix + "erode-cross" + suffix,
+            .type = "single",
+            .post = save_bricked_sample,
+            .func = [&] { parallel_for(input->size, BrickedErodeKernel<T>(layout.input, layout.output, cross_window)); },
+        });
+        builder.attach({
+            .name = prefix + "erode-cube" + suffix,
+            .type = "single",
+            .post = save_bricked_sample,
+            .func = [&] { parallel_for(input->size, BrickedErodeKernel<T>(layout.input, layout.output, cube_window)); },
+        });
+        builder.attach({
+            .name = prefix + "split-erode-cube" + suffix,
+            .type = "single",
+            .post = save_bricked_sample,
+            .func = [&] {
+                parallel_for(input->size, BrickedErodeKernel<T>(layout.input, layout.temp, cube_window_array[1]));
+                for (int i = 2; i <= dimensions; ++i)
+                    if (i & 0b1)
+                        parallel_for(input->size, BrickedErodeKernel<T>(layout.output, layout.temp, cube_window_array[i]));
+                    else
+                        parallel_for(input->size, BrickedErodeKernel<T>(layout.temp, layout.output, cube_window_array[i]));
+                if (dimensions & 0b1)
+                    parallel_for(layout.temp->capacity, [&](size_t i) { layout.output->data[i] = layout.temp->data[i]; });
+            },
+        });
+        builder.attach({
+            .name = prefix + "convolve" + suffix,
+            .type = "single",
+            .post = save_bricked_sample,
+            .func = [&] { parallel_for(input->size, BrickedConvolveKernel<T>(layout.input, layout.output, mean_window)); },
+        });
+        builder.attach({
+            .name = prefix + "split-convolve" + suffix,
+            .type = "single",
+            .post = save_bricked_sample,
+            .func = [&] {
+                parallel_for(input->size, BrickedConvolveKernel<T>(layout.input, layout.temp, mean_window_array[1]));
+                for (int i = 2; i <= dimensions; ++i)
+                    if (i & 0b1)
+                        parallel_for(input->size, BrickedConvolveKernel<T>(layout.output, layout.temp, mean_window_array[i]));
+                    else
+                        parallel_for(input->size, BrickedConvolveKernel<T>(layout.temp, layout.output, mean_window_array[i]));
+                if (dimensions & 0b1)
+                    parallel_for(layout.temp->capacity, [&](size_t i) { layout.output->data[i] = layout.temp->data[i]; });
+            },
+        });
+    }
+    builder.attach({
+        .name = "label-cross" + suffix,
+        .type = "single",
+        .post = save_label_sample,
+        .func = [&] { label(cross_window); },
+    });
+    builder.attach({
+        .name = "label-cube" + suffix,
+        .type = "single",
+        .post = save_label_sample,
+        .func = [&] { label(cube_window); },
+    });
+    for (size_t round = 0; round < rounds; ++round) {
+        co_await std::suspend_always();
+        builder.run(round, header);
+    }
+
+    image_destroy(input);
+    image_destroy(output);
+    image_destroy(temp);
+    image_destroy(mask);
+    image_destroy(labels);
+    image_destroy(distances);
+    image_destroy(distances_temp);
+    delete[] distance_vertex;
+    delete[] distance_boundary;
+    image_destroy(blur);
+    image_destroy(blur_temp);
+    for (size_t s = 0; s < gaussian_sigmas.size(); ++s)
+        for (int i = 1; i <= dimensions; ++i)
+            window_destroy(gaussian_window_array[s * (dimensions + 1) + i]);
+    window_destroy(cross_window);
+    window_destroy(cube_window);
+    window_destroy(cross_leading_window);
+    window_destroy(cross_trailing_window);
+    window_destroy(cube_leading_window);
+    window_destroy(cube_trailing_window);
+    image_destroy(reference);
+    for (int b = 1; b < pipeline->count; ++b)
+        image_destroy(pipeline_buffers[b]);
+    pipeline_plan_destroy(pipeline);
+    for (auto const& batch : batches) {
+        image_destroy(batch.input);
+        image_destroy(batch.output);
+    }
+    window_destroy(batch_cube_window);
+    window_destroy(batch_mean_window);
+    if (dimensions == 5) {
+        window_destroy(volume_cube_window);
+        window_destroy(axes_cube_window);
+    }
+    for (auto const& layout : layouts) {
+        bricked_image_destroy(layout.input);
+        bricked_image_destroy(layout.output);
+        bricked_image_destroy(layout.temp);
+    }
+    for (auto const& strel : strels) {
+        strel_plan_destroy(strel.plan);
+    }
+    for (auto const& psf : psfs) {
+        fft_plan_destroy(psf.plan);
+        window_destroy(psf.window);
+    }
+    delete[] fft_data;
+    delete[] fft_scratch;
+    window_destroy(mean_window);
+    for (auto i = 1; i <= dimensions; ++i) {
+        window_destroy(cube_window_array[i]);
+        window_destroy(mean_window_array[i]);
+    }
+    delete[] cube_window_array;
+    delete[] mean_window_array;
+}
+
+BenchmarkSession benchmark(VglImage* vglimage, size_t rounds, std::function<void(VglImage*, std::string)> save_image)
+{
+    // Threads are pinned through OMP_PLACES and OMP_PROC_BIND
+    constexpr char const* bindings[] = { "false", "true", "primary", "close", "spread" };
+    std::cerr << "threads: " << omp_get_max_threads() << ", places: " << omp_get_num_places()
+              << ", binding: " << bindings[omp_get_proc_bind()] << std::endl;
+
+    auto source = image_from_vglimage<uint8_t>(vglimage);
+
+    co_yield benchmark_voxel<uint8_t>(source, vglimage, rounds, save_image, true);
+    co_yield benchmark_voxel<uint16_t>(source, vglimage, rounds, save_image, false);
+    co_yield benchmark_voxel<float>(source, vglimage, rounds, save_image, false);
+
+    image_destroy(source);
+}
+
+BENCHMARK_PLUGIN_EXPORT BenchmarkPlugin const benchmark_plugin = {
+    .version = BENCHMARK_PLUGIN_VERSION,
+    .setup = benchmark,
+};
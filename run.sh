@@ -3,7 +3,137 @@
 PROJECT_ROOT=$PWD
 ROUNDS=${1:-0}
 
-cd $PROJECT_ROOT/visiongl && ./run.sh $ROUNDS
-cd $PROJECT_ROOT/sycl && ./run.sh $ROUNDS
-cd $PROJECT_ROOT/cuda && ./run.sh $ROUNDS
+TXT_FILENAME="benchmark.txt"
+CSV_FILENAME="benchmark.csv"
+LOG_FILENAME="benchmark.log"
+OUTPUT_FOLDER_BASE="$PROJECT_ROOT/results"
+IMAGE_PATTERN="$PROJECT_ROOT/assets/mitosis/mitosis-5d%04d.tif"
+INDEX_0=0
+INDEX_N=335
+DRIVER_FOLDER=$PROJECT_ROOT/shared/build
+DRIVER=$DRIVER_FOLDER/benchmark
+
+# Every backend is built once into a folder of its own and loaded as a plugin by one driver, which decodes the
+# volume once and interleaves the backends round by round. Variants that need an environment of their own, the
+# SYCL CPU device and the OpenMP binding sweeps, run the same plugins afterwards through separate invocations
+echo "Building benchmark driver"
+rm -rf $DRIVER_FOLDER
+cmake -G Ninja -S $PROJECT_ROOT/shared -B $DRIVER_FOLDER -D CMAKE_BUILD_TYPE=Release -D CMAKE_LINKER_TYPE=LLD -D CMAKE_CXX_COMPILER=clang++ > /dev/null 2>&1
+cmake --build $DRIVER_FOLDER > /dev/null 2>&1
+
+echo "Building VisionGL (Buffer) benchmark"
+rm -rf $PROJECT_ROOT/visiongl/build-buf
+cmake -G Ninja -S $PROJECT_ROOT/visiongl -B $PROJECT_ROOT/visiongl/build-buf -D CMAKE_BUILD_TYPE=Release -D CMAKE_LINKER_TYPE=LLD -D CMAKE_CXX_COMPILER=clang++ > /dev/null 2>&1
+cmake --build $PROJECT_ROOT/visiongl/build-buf > /dev/null 2>&1
+mkdir -p "$OUTPUT_FOLDER_BASE/vgl-buf" && echo "VisionGL (Buffer)" > "$OUTPUT_FOLDER_BASE/vgl-buf/$TXT_FILENAME"
+
+echo "Building VisionGL (Texture) benchmark"
+rm -rf $PROJECT_ROOT/visiongl/build-tex
+cmake -G Ninja -S $PROJECT_ROOT/visiongl -B $PROJECT_ROOT/visiongl/build-tex -D CMAKE_BUILD_TYPE=Release -D CMAKE_LINKER_TYPE=LLD -D CMAKE_CXX_COMPILER=clang++ -D FORCE_BUFFER=OFF > /dev/null 2>&1
+cmake --build $PROJECT_ROOT/visiongl/build-tex > /dev/null 2>&1
+mkdir -p "$OUTPUT_FOLDER_BASE/vgl-tex" && echo "VisionGL (Texture)" > "$OUTPUT_FOLDER_BASE/vgl-tex/$TXT_FILENAME"
+
+echo "Building SYCL (AdaptiveCpp) benchmark"
+rm -rf $PROJECT_ROOT/sycl/build-acpp
+cmake -G Ninja -S $PROJECT_ROOT/sycl -B $PROJECT_ROOT/sycl/build-acpp -D CMAKE_BUILD_TYPE=Release -D CMAKE_LINKER_TYPE=LLD -D CMAKE_CXX_COMPILER=acpp > /dev/null 2>&1
+cmake --build $PROJECT_ROOT/sycl/build-acpp > /dev/null 2>&1
+mkdir -p "$OUTPUT_FOLDER_BASE/sycl-acpp" && echo "SYCL (AdaptiveCpp)" > "$OUTPUT_FOLDER_BASE/sycl-acpp/$TXT_FILENAME"
+
+echo "Building SYCL (DPC++) benchmark"
+rm -rf $PROJECT_ROOT/sycl/build-dpcpp
+cmake -G Ninja -S $PROJECT_ROOT/sycl -B $PROJECT_ROOT/sycl/build-dpcpp -D CMAKE_BUILD_TYPE=Release -D CMAKE_CXX_COMPILER=icpx -D CMAKE_CXX_FLAGS="-fsycl -fsycl-targets=nvidia_gpu_sm_90" > /dev/null 2>&1
+cmake --build $PROJECT_ROOT/sycl/build-dpcpp > /dev/null 2>&1
+mkdir -p "$OUTPUT_FOLDER_BASE/sycl-dpcpp" && echo "SYCL (DPC++)" > "$OUTPUT_FOLDER_BASE/sycl-dpcpp/$TXT_FILENAME"
+
+echo "Building OpenMP benchmark"
+rm -rf $PROJECT_ROOT/openmp/build
+cmake -G Ninja -S $PROJECT_ROOT/openmp -B $PROJECT_ROOT/openmp/build -D CMAKE_BUILD_TYPE=Release -D CMAKE_LINKER_TYPE=LLD -D CMAKE_CXX_COMPILER=clang++ > /dev/null 2>&1
+cmake --build $PROJECT_ROOT/openmp/build > /dev/null 2>&1
+mkdir -p "$OUTPUT_FOLDER_BASE/openmp" && echo "OpenMP" > "$OUTPUT_FOLDER_BASE/openmp/$TXT_FILENAME"
+
+echo "Building PCUDA (AdaptiveCpp) benchmark"
+rm -rf $PROJECT_ROOT/cuda/build-acpp
+cmake -G Ninja -S $PROJECT_ROOT/cuda -B $PROJECT_ROOT/cuda/build-acpp -D CMAKE_BUILD_TYPE=Release -D CMAKE_LINKER_TYPE=LLD -D CMAKE_CXX_COMPILER=acpp > /dev/null 2>&1
+cmake --build $PROJECT_ROOT/cuda/build-acpp > /dev/null 2>&1
+mkdir -p "$OUTPUT_FOLDER_BASE/cuda-acpp" && echo "PCUDA (AdaptiveCpp)" > "$OUTPUT_FOLDER_BASE/cuda-acpp/$TXT_FILENAME"
+
+echo "Building CUDA (NVCC) benchmark"
+rm -rf $PROJECT_ROOT/cuda/build-nvcc
+cmake -G Ninja -S $PROJECT_ROOT/cuda -B $PROJECT_ROOT/cuda/build-nvcc -D CMAKE_BUILD_TYPE=Release -D CMAKE_LINKER_TYPE=LLD -D CMAKE_CXX_COMPILER=clang++ -D CMAKE_CUDA_COMPILER=nvcc > /dev/null 2>&1
+cmake --build $PROJECT_ROOT/cuda/build-nvcc > /dev/null 2>&1
+mkdir -p "$OUTPUT_FOLDER_BASE/cuda-nvcc" && echo "CUDA (NVCC)" > "$OUTPUT_FOLDER_BASE/cuda-nvcc/$TXT_FILENAME"
+
+PLUGINS="vgl-buf=$PROJECT_ROOT/visiongl/build-buf/libbenchmark.so"
+PLUGINS+=",sycl-acpp=$PROJECT_ROOT/sycl/build-acpp/libbenchmark.so"
+PLUGINS+=",sycl-dpcpp=$PROJECT_ROOT/sycl/build-dpcpp/libbenchmark.so"
+PLUGINS+=",openmp=$PROJECT_ROOT/openmp/build/libbenchmark.so"
+PLUGINS+=",cuda-acpp=$PROJECT_ROOT/cuda/build-acpp/libbenchmark.so"
+PLUGINS+=",cuda-nvcc=$PROJECT_ROOT/cuda/build-nvcc/libbenchmark.so"
+TEXTURE_PLUGINS="$PLUGINS,vgl-tex=$PROJECT_ROOT/visiongl/build-tex/libbenchmark.so"
+
+OUTPUT_FOLDER="$OUTPUT_FOLDER_BASE/interleaved"
+mkdir -p "$OUTPUT_FOLDER/1D" "$OUTPUT_FOLDER/2D" "$OUTPUT_FOLDER/3D" "$OUTPUT_FOLDER/4D" "$OUTPUT_FOLDER/5D"
+echo "Running interleaved 1D benchmark"
+ACPP_DEBUG_LEVEL=0 $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/1D $PLUGINS 22020096               > "$OUTPUT_FOLDER/1D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/1D/$LOG_FILENAME"
+echo "Running interleaved 2D benchmark"
+ACPP_DEBUG_LEVEL=0 $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/2D $TEXTURE_PLUGINS 256 86016      > "$OUTPUT_FOLDER/2D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/2D/$LOG_FILENAME"
+echo "Running interleaved 3D benchmark"
+ACPP_DEBUG_LEVEL=0 $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/3D $TEXTURE_PLUGINS 256 256 336    > "$OUTPUT_FOLDER/3D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/3D/$LOG_FILENAME"
+echo "Running interleaved 4D benchmark"
+ACPP_DEBUG_LEVEL=0 $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/4D $PLUGINS 256 256 2 168          > "$OUTPUT_FOLDER/4D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/4D/$LOG_FILENAME"
+echo "Running interleaved 5D benchmark"
+ACPP_DEBUG_LEVEL=0 $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/5D $PLUGINS 256 256 2 24 7         > "$OUTPUT_FOLDER/5D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/5D/$LOG_FILENAME"
+echo "Results and logs saved in $(realpath $OUTPUT_FOLDER)"
+
+PLUGIN=$PROJECT_ROOT/sycl/build-acpp/libbenchmark.so
+OUTPUT_FOLDER="$OUTPUT_FOLDER_BASE/sycl-acpp-cpu"
+TECH_NAME="SYCL (AdaptiveCpp, CPU)"
+mkdir -p "$OUTPUT_FOLDER/2D" "$OUTPUT_FOLDER/3D" "$OUTPUT_FOLDER/4D" "$OUTPUT_FOLDER/5D"
+echo $TECH_NAME > "$OUTPUT_FOLDER/$TXT_FILENAME"
+echo "Running $TECH_NAME 2D benchmark"
+ACPP_DEBUG_LEVEL=0 ACPP_VISIBILITY_MASK=omp $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/2D $PLUGIN 256 86016      > "$OUTPUT_FOLDER/2D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/2D/$LOG_FILENAME"
+echo "Running $TECH_NAME 3D benchmark"
+ACPP_DEBUG_LEVEL=0 ACPP_VISIBILITY_MASK=omp $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/3D $PLUGIN 256 256 336    > "$OUTPUT_FOLDER/3D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/3D/$LOG_FILENAME"
+echo "Running $TECH_NAME 4D benchmark"
+ACPP_DEBUG_LEVEL=0 ACPP_VISIBILITY_MASK=omp $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/4D $PLUGIN 256 256 2 168  > "$OUTPUT_FOLDER/4D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/4D/$LOG_FILENAME"
+echo "Running $TECH_NAME 5D benchmark"
+ACPP_DEBUG_LEVEL=0 ACPP_VISIBILITY_MASK=omp $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/5D $PLUGIN 256 256 2 24 7 > "$OUTPUT_FOLDER/5D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/5D/$LOG_FILENAME"
+echo "Results and logs saved in $(realpath $OUTPUT_FOLDER)"
+
+# Cores listed socket by socket so that close binding fills one socket before the next, one place per core
+PLUGIN=$PROJECT_ROOT/openmp/build/libbenchmark.so
+SOCKETS=$(lscpu -p=SOCKET | grep -v '^#' | sort -u | wc -l)
+CORES_PER_SOCKET=$(lscpu -p=CORE,SOCKET | grep -v '^#' | sort -u | grep -c ',0$')
+PLACES=$(lscpu -p=CPU,CORE,SOCKET | grep -v '^#' | sort -t, -k3,3n -k2,2n | awk -F, '!seen[$2","$3]++ { printf "%s{%s}", sep, $1; sep = "," }')
+
+for BINDING in close spread; do
+    for ((SOCKET_COUNT = 1; SOCKET_COUNT <= SOCKETS; ++SOCKET_COUNT)); do
+        # Scattering over every socket with all cores busy is the compact run again
+        if [ $BINDING = spread ] && [ $SOCKET_COUNT = $SOCKETS ]; then
+            continue
+        fi
+        THREADS=$((SOCKET_COUNT * CORES_PER_SOCKET))
+        if [ $BINDING = close ]; then
+            OUTPUT_FOLDER="$OUTPUT_FOLDER_BASE/openmp-compact-$SOCKET_COUNT"
+            TECH_NAME="OpenMP (compact, $THREADS threads on $SOCKET_COUNT of $SOCKETS sockets)"
+        else
+            OUTPUT_FOLDER="$OUTPUT_FOLDER_BASE/openmp-scatter-$SOCKET_COUNT"
+            TECH_NAME="OpenMP (scatter, $THREADS threads over $SOCKETS sockets)"
+        fi
+        mkdir -p "$OUTPUT_FOLDER/1D" "$OUTPUT_FOLDER/2D" "$OUTPUT_FOLDER/3D" "$OUTPUT_FOLDER/4D" "$OUTPUT_FOLDER/5D"
+        echo $TECH_NAME > "$OUTPUT_FOLDER/$TXT_FILENAME"
+        echo "Running $TECH_NAME 1D benchmark"
+        OMP_NUM_THREADS=$THREADS OMP_PLACES=$PLACES OMP_PROC_BIND=$BINDING $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/1D $PLUGIN 22020096       > "$OUTPUT_FOLDER/1D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/1D/$LOG_FILENAME"
+        echo "Running $TECH_NAME 2D benchmark"
+        OMP_NUM_THREADS=$THREADS OMP_PLACES=$PLACES OMP_PROC_BIND=$BINDING $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/2D $PLUGIN 256 86016      > "$OUTPUT_FOLDER/2D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/2D/$LOG_FILENAME"
+        echo "Running $TECH_NAME 3D benchmark"
+        OMP_NUM_THREADS=$THREADS OMP_PLACES=$PLACES OMP_PROC_BIND=$BINDING $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/3D $PLUGIN 256 256 336    > "$OUTPUT_FOLDER/3D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/3D/$LOG_FILENAME"
+        echo "Running $TECH_NAME 4D benchmark"
+        OMP_NUM_THREADS=$THREADS OMP_PLACES=$PLACES OMP_PROC_BIND=$BINDING $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/4D $PLUGIN 256 256 2 168  > "$OUTPUT_FOLDER/4D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/4D/$LOG_FILENAME"
+        echo "Running $TECH_NAME 5D benchmark"
+        OMP_NUM_THREADS=$THREADS OMP_PLACES=$PLACES OMP_PROC_BIND=$BINDING $DRIVER $IMAGE_PATTERN $INDEX_0 $INDEX_N $ROUNDS $OUTPUT_FOLDER/5D $PLUGIN 256 256 2 24 7 > "$OUTPUT_FOLDER/5D/$CSV_FILENAME" 2> "$OUTPUT_FOLDER/5D/$LOG_FILENAME"
+        echo "Results and logs saved in $(realpath $OUTPUT_FOLDER)"
+    done
+done
+
 cd $PROJECT_ROOT/matlab && ./run.sh $ROUNDS
@@ -1,29 +1,242 @@
 #ifndef DIP_ND_BENCHMARK_UTILS_HPP
 #define DIP_ND_BENCHMARK_UTILS_HPP
 
+#include <cmath>
+#include <coroutine>
 #include <cstdint>
 #include <functional>
+#include <limits>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include <visiongl/image.hpp>
 #include <visiongl/strel.hpp>
 
+// Integer voxels span their full range, float voxels are normalized to [0, 1]
+template<typename T>
+struct VoxelTraits;
+
+template<>
+struct VoxelTraits<uint8_t> {
+    static constexpr uint8_t max = std::numeric_limits<uint8_t>::max();
+    static constexpr char const* name = "uint8";
+};
+
+template<>
+struct VoxelTraits<uint16_t> {
+    static constexpr uint16_t max = std::numeric_limits<uint16_t>::max();
+    static constexpr char const* name = "uint16";
+};
+
+template<>
+struct VoxelTraits<float> {
+    static constexpr float max = 1.0f;
+    static constexpr char const* name = "float32";
+};
+
+template<typename T>
+constexpr T voxel_from_uint8(uint8_t value)
+{
+    return T(value * VoxelTraits<T>::max / 255);
+}
+
+template<typename T>
+constexpr uint8_t voxel_to_uint8(T value)
+{
+    if constexpr (std::is_floating_point_v<T>)
+        return uint8_t((value < 0 ? 0 : value > 1 ? 1 : value) * 255.0f + 0.5f);
+    else
+        return uint8_t((value * 255 + VoxelTraits<T>::max / 2) / VoxelTraits<T>::max);
+}
+
+constexpr int HISTOGRAM_BINS = 256;
+
+template<typename T>
+constexpr int voxel_bin(T value)
+{
+    if constexpr (std::is_floating_point_v<T>)
+        return value <= 0 ? 0 : value >= 1 ? HISTOGRAM_BINS - 1 : int(value * HISTOGRAM_BINS);
+    else
+        return int(uint32_t(value) * HISTOGRAM_BINS / (uint32_t(VoxelTraits<T>::max) + 1));
+}
+
+// Upper edge of the bin
+template<typename T>
+constexpr T voxel_from_bin(int bin)
+{
+    if constexpr (std::is_floating_point_v<T>)
+        return T(bin + 1) / HISTOGRAM_BINS;
+    else
+        return T((uint32_t(bin) + 1) * (uint32_t(VoxelTraits<T>::max) + 1) / HISTOGRAM_BINS - 1);
+}
+
+// Otsu's level as a bin, voxels in bins above it are foreground
+inline int otsu_threshold(uint32_t const* histogram)
+{
+    double total = 0;
+    double weighted_total = 0;
+    for (int bin = 0; bin < HISTOGRAM_BINS; ++bin) {
+        total += histogram[bin];
+        weighted_total += double(bin) * histogram[bin];
+    }
+
+    double background = 0;
+    double weighted_background = 0;
+    double best_variance = 0;
+    int level = 0;
+    for (int bin = 0; bin < HISTOGRAM_BINS; ++bin) {
+        background += histogram[bin];
+        if (background == 0)
+            continue;
+
+        double foreground = total - background;
+        if (foreground == 0)
+            break;
+
+        weighted_background += double(bin) * histogram[bin];
+        double mean_background = weighted_background / background;
+        double mean_foreground = (weighted_total - weighted_background) / foreground;
+        double variance = background * foreground * (mean_background - mean_foreground) * (mean_background - mean_foreground);
+
+        if (variance > best_variance) {
+            best_variance = variance;
+            level = bin;
+        }
+    }
+
+    return level;
+}
+
+template<typename T>
+struct Statistics {
+    T min;
+    T max;
+    double sum;
+    double mean;
+};
+
+template<typename T>
 struct Image {
-    uint8_t* data;
+    T* data;
     int* shape;
     int* offset;
     uint8_t dimensions;
     size_t size;
 };
 
-struct DeviceImage : Image {
-    Image* self;
+template<typename T>
+struct DeviceImage : Image<T> {
+    Image<T>* self;
 };
 
-Image* image_from_vglimage(VglImage* vglimage);
-Image* image_convert_from_vglimage(VglImage* vglimage);
-void image_destroy(Image* image);
+template<typename T>
+Image<T>* image_from_vglimage(VglImage* vglimage);
+template<typename T>
+Image<T>* image_convert_from_vglimage(VglImage* vglimage);
+template<typename T>
+void image_to_vglimage(Image<T>* image, VglImage* vglimage);
+template<typename T>
+Image<T>* image_similar_from_image(Image<T>* image);
+template<typename T, typename U>
+Image<T>* image_cast(Image<U>* image);
+template<typename T>
+void image_destroy(Image<T>* image);
+
+constexpr int BINARY_WORD_BITS = 64;
+
+struct BinaryImage {
+    uint64_t* data;
+    int* shape;
+    int* offset;
+    uint8_t dimensions;
+    size_t size;
+};
+
+struct DeviceBinaryImage : BinaryImage {
+    BinaryImage* self;
+};
+
+template<typename T>
+BinaryImage* binary_image_similar_from_image(Image<T>* image);
+template<typename T>
+BinaryImage* binary_image_from_image(Image<T>* image, T threshold = 0);
+template<typename T>
+Image<T>* image_from_binary_image(BinaryImage* binary, T max_value = VoxelTraits<T>::max);
+void binary_image_destroy(BinaryImage* binary);
+
+// Voxels grouped in bricks of brick_edge^dimensions, the position of a voxel is a sum of one table entry per axis
+enum class BrickOrder {
+    ROW_MAJOR,
+    MORTON
+};
+
+constexpr int brick_edge(uint8_t dimensions)
+{
+    constexpr int edges[] = { 1, 64, 16, 8, 4, 4 };
+    return edges[dimensions];
+}
+
+template<typename T>
+struct BrickedImage {
+    T* data;
+    int* shape;
+    int* offset;
+    size_t* table;
+    int* table_offset;
+    uint8_t dimensions;
+    size_t size;
+    size_t capacity;
+};
+
+template<typename T>
+struct DeviceBrickedImage : BrickedImage<T> {
+    BrickedImage<T>* self;
+};
+
+template<typename T>
+BrickedImage<T>* bricked_image_similar_from_image(Image<T>* image, BrickOrder order);
+template<typename T>
+BrickedImage<T>* bricked_image_from_image(Image<T>* image, BrickOrder order);
+template<typename T>
+void bricked_image_destroy(BrickedImage<T>* bricked);
+
+// Foreground voxels are labeled with one plus the linear index of their component root, background with zero
+using LabelImage = Image<uint32_t>;
+
+template<typename T>
+LabelImage* label_image_similar_from_image(Image<T>* image);
+void label_image_to_vglimage(LabelImage* labels, VglImage* vglimage);
+
+// Finite so that parabola intersections between unreached voxels never evaluate inf - inf
+constexpr float DISTANCE_INFINITY = 1e20f;
+
+void distance_image_to_vglimage(Image<float>* distances, VglImage* vglimage);
+
+// Young and van Vliet third order recursive Gaussian, normalized to leave constant signals unchanged
+struct GaussianCoefficients {
+    float b;
+    float a1;
+    float a2;
+    float a3;
+};
+
+inline GaussianCoefficients gaussian_coefficients(float sigma)
+{
+    double q = sigma >= 2.5 ? 0.98711 * sigma - 0.96330 : 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * sigma);
+    double b0 = 1.57825 + 2.44413 * q + 1.4281 * q * q + 0.422205 * q * q * q;
+    double b1 = 2.44413 * q + 2.85619 * q * q + 1.26661 * q * q * q;
+    double b2 = -(1.4281 * q * q + 1.26661 * q * q * q);
+    double b3 = 0.422205 * q * q * q;
+
+    return {
+        .b = float(1.0 - (b1 + b2 + b3) / b0),
+        .a1 = float(b1 / b0),
+        .a2 = float(b2 / b0),
+        .a3 = float(b3 / b0),
+    };
+}
 
 struct Window {
     float* data;
@@ -47,6 +260,196 @@ Window* window_from_vglstrel(VglStrEl* vglstrel);
 Window* window_convert_from_vglstrel(VglStrEl* vglstrel);
 void window_destroy(Window* window);
 Window* window_create_from_type(WindowType type, uint8_t dimension);
+Window* window_create_axis_from_type(WindowType type, uint8_t dimension, uint8_t axis);
+Window* window_create_gaussian_axis(float sigma, uint8_t dimension, uint8_t axis);
+Window* window_create_gaussian(float sigma, uint8_t dimension);
+Window* window_create_edge_from_window(Window* window, uint8_t axis, int step);
+size_t window_count(Window* window);
+// Whether the window equals its reflection about the center, so dilation may sweep it unreflected
+bool window_symmetric(Window* window);
+
+// Volumes of a batch are stacked along trailing axes that windows span with extent one
+constexpr size_t BATCH_VOLUME_SIZE = 4096;
+
+// Largest edge whose hypercube still fits in the volume size
+constexpr int batch_volume_edge(uint8_t dimension)
+{
+    auto fits = [dimension](size_t edge) {
+        size_t size = 1;
+        for (int d = 0; d < dimension; ++d)
+            size *= edge;
+        return size <= BATCH_VOLUME_SIZE;
+    };
+
+    int edge = 1;
+    while (fits(edge + 1))
+        ++edge;
+    return edge;
+}
+
+template<typename T>
+Image<T>* image_batch_from_image(Image<T>* image, int edge, int count);
+Window* window_batch_from_window(Window* window, uint8_t batch_dimension);
+
+// Larger windows are ranked by a sliding histogram for uint8 voxels, by selection otherwise
+constexpr int RANK_NETWORK_SIZE = 16;
+// Gather sizes of the selection, cubes in three to five dimensions, the smallest holding the window is used
+constexpr int RANK_WINDOW_SIZES[] = { 27, 81, 243 };
+
+constexpr int rank_from_percentile(float percentile, size_t count)
+{
+    return int(percentile / 100.0f * (count - 1) + 0.5f);
+}
+
+enum class StrelType {
+    BALL,
+    DIAMOND,
+    ELLIPSOID
+};
+
+// Each window pass streams the whole image once more, weighed against the window taps it saves
+constexpr size_t STREL_PASS_COST = 8;
+
+// Radii are indexed from one like shapes, balls and diamonds read only the first one
+Window* window_create_strel(StrelType type, int const* radii, uint8_t dimension);
+Window* window_create_line(uint8_t dimension, uint8_t axis, int radius);
+
+// Steps applied one after the other erode or dilate like a single pass over window, empty when that is cheaper
+struct StrelPlan {
+    Window* window;
+    std::vector<Window*> steps;
+};
+
+StrelPlan* strel_plan_create(StrelType type, int const* radii, uint8_t dimension);
+void strel_plan_destroy(StrelPlan* plan);
+
+// Transform lengths are products of these radices, larger ones first
+constexpr int FFT_RADICES[] = { 5, 3, 2 };
+constexpr int FFT_MAX_RADIX = 5;
+// Voxels of one overlap-save tile and complex values transformed per launch
+constexpr size_t FFT_TILE_SIZE = 1 << 18;
+constexpr size_t FFT_BATCH_SIZE = 1 << 22;
+// Cost of one complex value per radix stage against one direct tap, tuned with the OpenMP backend only
+constexpr float FFT_STAGE_COST = 2.0f;
+
+// Stockham transform of n interleaved complex values stride apart, twiddles holds exp(-2 pi i m / n)
+inline void fft_line(float* data, float* scratch, size_t stride, int n, int const* radices, int radix_count, float const* twiddles, bool inverse)
+{
+    float sign = inverse ? -1.0f : 1.0f;
+    float* input = data;
+    float* output = scratch;
+
+    int l = 1;
+    for (int stage = 0; stage < radix_count; ++stage) {
+        int p = radices[stage];
+        int r = n / (l * p);
+
+        for (int j = 0; j < l; ++j) {
+            for (int k = 0; k < r; ++k) {
+                float a_real[FFT_MAX_RADIX];
+                float a_imag[FFT_MAX_RADIX];
+                for (int q = 0; q < p; ++q) {
+                    size_t index = 2 * (k + r * q + r * p * j) * stride;
+                    float w_real = twiddles[2 * (j * q * r % n)];
+                    float w_imag = sign * twiddles[2 * (j * q * r % n) + 1];
+                    a_real[q] = input[index] * w_real - input[index + 1] * w_imag;
+                    a_imag[q] = input[index] * w_imag + input[index + 1] * w_real;
+                }
+
+                for (int s = 0; s < p; ++s) {
+                    float sum_real = 0.0f;
+                    float sum_imag = 0.0f;
+                    for (int q = 0; q < p; ++q) {
+                        int m = s * q % p * (n / p);
+                        float w_real = twiddles[2 * m];
+                        float w_imag = sign * twiddles[2 * m + 1];
+                        sum_real += a_real[q] * w_real - a_imag[q] * w_imag;
+                        sum_imag += a_real[q] * w_imag + a_imag[q] * w_real;
+                    }
+
+                    size_t index = 2 * (k + r * (j + l * s)) * stride;
+                    output[index] = sum_real;
+                    output[index + 1] = sum_imag;
+                }
+            }
+        }
+
+        float* swap = input;
+        input = output;
+        output = swap;
+        l *= p;
+    }
+
+    if (input != data)
+        for (int e = 0; e < n; ++e) {
+            data[2 * e * stride] = input[2 * e * stride];
+            data[2 * e * stride + 1] = input[2 * e * stride + 1];
+        }
+}
+
+// Overlap-save tiling, tiles are transformed in pairs through the real and imaginary parts
+struct FftPlan {
+    int* shape;
+    int* offset;
+    int* valid;
+    int* grid;
+    int* anchor;
+    int* radices;
+    int* radix_offset;
+    float* twiddles;
+    int* twiddle_offset;
+    float* spectrum;
+    uint8_t dimensions;
+    size_t size;
+    size_t tiles;
+    size_t pairs;
+    size_t batch;
+};
+
+struct DeviceFftPlan : FftPlan {
+    FftPlan* self;
+};
+
+int fft_length(int size);
+FftPlan* fft_plan_create(int const* shape, uint8_t dimension, Window* window);
+void fft_plan_destroy(FftPlan* plan);
+bool fft_plan_preferred(FftPlan* plan, Window* window, size_t size);
+
+// Chained operators read and write numbered images, image zero is the chain input and is never written
+struct PipelineStep {
+    int input;
+    int output;
+    // Reads only the voxel it writes, so it may overwrite an input that is not read afterwards
+    bool point;
+};
+
+// Buffer of every image, images with disjoint lifetimes share one and buffer zero holds the input
+struct PipelinePlan {
+    std::vector<int> buffers;
+    int count;
+};
+
+PipelinePlan* pipeline_plan_create(std::vector<PipelineStep> const& steps);
+void pipeline_plan_destroy(PipelinePlan* plan);
+
+// Host counters follow the global operator new, device counters the allocation helpers of each backend
+struct MemoryCounters {
+    size_t allocations;
+    size_t bytes;
+    size_t live;
+    size_t peak;
+};
+
+struct MemoryUsage {
+    MemoryCounters host;
+    MemoryCounters device;
+    size_t resident;
+};
+
+MemoryUsage memory_usage();
+void memory_reset_peak();
+void memory_track_device_allocation(void* pointer, size_t bytes);
+void memory_track_device_free(void* pointer);
 
 struct BenchmarkSpec {
     std::string name;
@@ -56,17 +459,72 @@ struct BenchmarkSpec {
     std::function<void(void)> func;
 };
 
+// Counters are process-wide, so every column is a growth over the round, which holds with other backends loaded
+constexpr char const* BENCHMARK_REPORT_COLUMNS = "operator,type,group,duration,"
+                                                  "host_allocations,host_bytes,host_peak,device_allocations,device_bytes,device_peak,"
+                                                  "rss_growth";
+
+// Columns written ahead of every row, set by a driver that writes the header itself
+void benchmark_report_lead(std::string columns);
+
 class BenchmarkBuilder {
 private:
     std::vector<BenchmarkSpec> m_specs;
 
-    void perform_benchmark(std::size_t rounds, BenchmarkSpec const& spec);
+    void perform_round(std::size_t round, BenchmarkSpec const& spec);
 
 public:
     void attach(BenchmarkSpec&& spec);
-    void run(std::size_t rounds);
+    // Times every spec once, the first round also warms them up, runs their post and writes the header
+    void run(std::size_t round, bool header = true);
+};
+
+// Benchmark of one backend suspended ahead of each round, nested sessions run all their rounds first
+class BenchmarkSession {
+public:
+    struct promise_type {
+        std::unique_ptr<BenchmarkSession> nested;
+
+        BenchmarkSession get_return_object() { return BenchmarkSession(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(BenchmarkSession&& session)
+        {
+            nested = std::make_unique<BenchmarkSession>(std::move(session));
+            return {};
+        }
+        void return_void() { }
+        void unhandled_exception() { throw; }
+    };
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+
+    explicit BenchmarkSession(std::coroutine_handle<promise_type> handle)
+        : m_handle(handle)
+    {
+    }
+
+public:
+    BenchmarkSession(BenchmarkSession&& other) noexcept;
+    BenchmarkSession& operator=(BenchmarkSession&& other) = delete;
+    ~BenchmarkSession();
+
+    // Runs the next round, setting builders up and tearing them down on the way, false once none is left
+    bool run();
+};
+
+BenchmarkSession benchmark(VglImage* vglimage, size_t rounds, std::function<void(VglImage*, std::string)> save_image);
+
+// Entry point every backend library exports under BENCHMARK_PLUGIN_SYMBOL
+constexpr int BENCHMARK_PLUGIN_VERSION = 2;
+constexpr char const* BENCHMARK_PLUGIN_SYMBOL = "benchmark_plugin";
+
+struct BenchmarkPlugin {
+    int version;
+    BenchmarkSession (*setup)(VglImage* vglimage, size_t rounds, std::function<void(VglImage*, std::string)> save_image);
 };
 
-void benchmark(VglImage* vglimage, size_t rounds, std::function<void(VglImage*, std::string)> save_image);
+#define BENCHMARK_PLUGIN_EXPORT extern "C" __attribute__((visibility("default")))
 
 #endif // DIP_ND_BENCHMARK_UTILS_HPP
@@ -1,6 +1,13 @@
+#include <algorithm>
 #include <cstring>
 #include <filesystem>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dlfcn.h>
 
 #include <visiongl/context.hpp>
 #include <visiongl/image.hpp>
@@ -8,13 +15,21 @@
 
 #include <utils.hpp>
 
+struct Backend {
+    std::string name;
+    void* handle;
+    BenchmarkPlugin const* plugin;
+    VglImage* image = nullptr;
+    std::unique_ptr<BenchmarkSession> session = nullptr;
+};
+
 int main(int argc, char** argv)
 {
-    auto usage = "Usage: benchmark <input pattern> <index 0> <index n> <rounds> <output folder> [<d1> <d2> ... <dN>]\n";
+    auto usage = "Usage: benchmark <input pattern> <index 0> <index n> <rounds> <output folder> <[name=]plugin,...> <d1> [<d2> ... <dN>]\n";
 
-    constexpr int ARGD1 = 6;
+    constexpr int ARGD1 = 7;
 
-    if (argc < ARGD1) {
+    if (argc <= ARGD1) {
         std::cout << usage << "\n";
         std::exit(EXIT_FAILURE);
     }
@@ -25,15 +40,32 @@ int main(int argc, char** argv)
     int rounds = atoi(argv[4]);
     char* outpath = argv[5];
 
-    int shape[VGL_ARR_SHAPE_SIZE] = { 0 };
-    int ndim = 3;
-    if (argc < ARGD1) {
-        shape[VGL_SHAPE_D3] = iN - i0 + 1;
-    } else {
-        ndim = argc - ARGD1;
-        for (int i = 0; i < ndim; i++) {
-            shape[1 + i] = atoi(argv[ARGD1 + i]);
+    auto backends = std::vector<Backend>();
+    auto plugins = std::stringstream(argv[6]);
+    for (std::string entry; std::getline(plugins, entry, ',');) {
+        auto separator = entry.find('=');
+        auto name = separator == std::string::npos ? std::string() : entry.substr(0, separator);
+        auto path = separator == std::string::npos ? entry : entry.substr(separator + 1);
+
+        auto handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (handle == nullptr) {
+            std::cerr << dlerror() << "\n";
+            std::exit(EXIT_FAILURE);
         }
+
+        auto plugin = static_cast<BenchmarkPlugin const*>(dlsym(handle, BENCHMARK_PLUGIN_SYMBOL));
+        if (plugin == nullptr || plugin->version != BENCHMARK_PLUGIN_VERSION) {
+            std::cerr << path << ": not a benchmark plugin of version " << BENCHMARK_PLUGIN_VERSION << "\n";
+            std::exit(EXIT_FAILURE);
+        }
+
+        backends.push_back({ name, handle, plugin });
+    }
+
+    int shape[VGL_ARR_SHAPE_SIZE] = { 0 };
+    int ndim = argc - ARGD1;
+    for (int i = 0; i < ndim; i++) {
+        shape[1 + i] = atoi(argv[ARGD1 + i]);
     }
 
     auto tmppath = new char[strlen(outpath) + 256];
@@ -50,22 +82,60 @@ int main(int argc, char** argv)
     auto vglshape = new VglShape(baseShape, 3);
     auto vglimage = vglLoadNdImage(inpath, i0, iN, shape, ndim);
 
-    benchmark(vglimage, rounds, [&](VglImage* output, std::string codename) {
-        vglCheckContext(output, VGL_RAM_CONTEXT);
-        if (ndim <= 2)
-            vglReshape(output, vglshape);
-
-        auto outfilename = new char[strlen(outpath) + 256];
-        sprintf(outfilename, "%s/%s", outpath, codename.c_str());
-
-        if (!std::filesystem::exists(outfilename))
-            std::filesystem::create_directories(outfilename);
+    // Samples of each backend go to a folder of its own when several of them share the output folder
+    auto save_image = [&](std::string name) {
+        return [&, name](VglImage* output, std::string codename) {
+            vglCheckContext(output, VGL_RAM_CONTEXT);
+            if (ndim <= 2)
+                vglReshape(output, vglshape);
+
+            auto outfilename = new char[strlen(outpath) + name.size() + 256];
+            sprintf(outfilename, "%s/%s%s%s", outpath, name.c_str(), name.empty() ? "" : "/", codename.c_str());
+
+            if (!std::filesystem::exists(outfilename))
+                std::filesystem::create_directories(outfilename);
+
+            sprintf(outfilename, "%s/%%05d.tif", outfilename);
+            vglSaveNdImage(outfilename, output, i0);
+
+            delete[] outfilename;
+        };
+    };
+
+    // Backends set up once on copies of the volume take turns, starting one further along every round
+    rounds = std::max(rounds, 1);
+    if (backends.size() > 1)
+        std::cout << "backend,round," << BENCHMARK_REPORT_COLUMNS << "\n";
+    for (auto& backend : backends) {
+        backend.image = vglCreateImage(vglimage);
+        vglSetContext(backend.image, VGL_RAM_CONTEXT);
+        std::copy_n(vglimage->getImageData(), vglimage->vglShape->getSize(), backend.image->getImageData());
+        backend.session = std::make_unique<BenchmarkSession>(backend.plugin->setup(backend.image, rounds, save_image(backend.name)));
+    }
 
-        sprintf(outfilename, "%s/%%05d.tif", outfilename);
-        vglSaveNdImage(outfilename, output, i0);
+    // Builders of a backend run their rounds one after another
+    for (size_t round = 0, active = backends.size(); active > 0; ++round) {
+        active = 0;
+        for (size_t b = 0; b < backends.size(); ++b) {
+            auto& backend = backends[(round + b) % backends.size()];
+            if (backend.session == nullptr)
+                continue;
+
+            if (backends.size() > 1)
+                benchmark_report_lead(backend.name + "," + std::to_string(round % rounds) + ",");
+            if (backend.session->run()) {
+                ++active;
+                continue;
+            }
+
+            backend.session = nullptr;
+            delete backend.image;
+        }
+    }
+    benchmark_report_lead("");
 
-        delete[] outfilename;
-    });
+    for (auto const& backend : backends)
+        dlclose(backend.handle);
 
     delete vglimage;
     delete vglshape;
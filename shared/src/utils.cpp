@@ -1,44 +1,105 @@
 #include <algorithm>
+#include <atomic>
+#include <bit>
 #include <chrono>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <functional>
 #include <iostream>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <numbers>
+#include <numeric>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <visiongl/constants.hpp>
 #include <visiongl/image.hpp>
 #include <visiongl/shape.hpp>
 
 #include <utils.hpp>
 #include <visiongl/strel.hpp>
 
-Image* image_from_vglimage(VglImage* vglimage)
+template<typename T>
+Image<T>* image_from_vglimage(VglImage* vglimage)
 {
-    auto image = new Image();
+    auto image = new Image<T>();
 
-    image->data = new uint8_t[vglimage->vglShape->getSize()];
+    image->data = new T[vglimage->vglShape->getSize()];
     image->shape = new int[vglimage->vglShape->getNdim() + 1];
     image->offset = new int[vglimage->vglShape->getNdim() + 1];
     image->dimensions = vglimage->vglShape->getNdim();
     image->size = vglimage->vglShape->getSize();
 
-    std::copy_n(vglimage->getImageData(), image->size, image->data);
+    std::transform(vglimage->getImageData(), vglimage->getImageData() + image->size, image->data, voxel_from_uint8<T>);
     std::copy_n(vglimage->vglShape->getShape(), image->dimensions + 1, image->shape);
     std::copy_n(vglimage->vglShape->getOffset(), image->dimensions + 1, image->offset);
 
     return image;
 }
 
-Image* image_convert_from_vglimage(VglImage* vglimage)
+template<typename T>
+Image<T>* image_convert_from_vglimage(VglImage* vglimage)
 {
-    auto image = image_from_vglimage(vglimage);
+    auto image = image_from_vglimage<T>(vglimage);
 
     delete vglimage;
 
     return image;
 }
 
-void image_destroy(Image* image)
+template<typename T>
+void image_to_vglimage(Image<T>* image, VglImage* vglimage)
+{
+    std::transform(image->data, image->data + image->size, vglimage->getImageData(), voxel_to_uint8<T>);
+}
+
+template<typename T>
+Image<T>* image_similar_from_image(Image<T>* image)
+{
+    auto similar = new Image<T>();
+
+    similar->data = new T[image->size];
+    similar->shape = new int[image->dimensions + 1];
+    similar->offset = new int[image->dimensions + 1];
+    similar->dimensions = image->dimensions;
+    similar->size = image->size;
+
+    std::copy_n(image->shape, image->dimensions + 1, similar->shape);
+    std::copy_n(image->offset, image->dimensions + 1, similar->offset);
+
+    return similar;
+}
+
+template<typename T, typename U>
+Image<T>* image_cast(Image<U>* image)
+{
+    auto cast = new Image<T>();
+
+    cast->data = new T[image->size];
+    cast->shape = new int[image->dimensions + 1];
+    cast->offset = new int[image->dimensions + 1];
+    cast->dimensions = image->dimensions;
+    cast->size = image->size;
+
+    std::transform(image->data, image->data + image->size, cast->data, [](U value) { return voxel_from_uint8<T>(voxel_to_uint8<U>(value)); });
+    std::copy_n(image->shape, image->dimensions + 1, cast->shape);
+    std::copy_n(image->offset, image->dimensions + 1, cast->offset);
+
+    return cast;
+}
+
+template<typename T>
+void image_destroy(Image<T>* image)
 {
     delete[] image->data;
     delete[] image->shape;
@@ -46,6 +107,301 @@ void image_destroy(Image* image)
     delete image;
 }
 
+template<typename T>
+BinaryImage* binary_image_similar_from_image(Image<T>* image)
+{
+    auto binary = new BinaryImage();
+
+    binary->shape = new int[image->dimensions + 1];
+    binary->offset = new int[image->dimensions + 1];
+    binary->dimensions = image->dimensions;
+
+    std::copy_n(image->shape, image->dimensions + 1, binary->shape);
+
+    // Innermost axis is packed into words, remaining axes are plain row-major strides over words
+    binary->offset[0] = 1;
+    binary->offset[1] = 1;
+    binary->size = (image->shape[1] + BINARY_WORD_BITS - 1) / BINARY_WORD_BITS;
+    for (int d = 2; d <= binary->dimensions; ++d) {
+        binary->offset[d] = binary->size;
+        binary->size *= image->shape[d];
+    }
+
+    binary->data = new uint64_t[binary->size]();
+
+    return binary;
+}
+
+template<typename T>
+BinaryImage* binary_image_from_image(Image<T>* image, T threshold)
+{
+    auto binary = binary_image_similar_from_image(image);
+    auto row_words = binary->dimensions > 1 ? binary->offset[2] : binary->size;
+
+    for (size_t word_index = 0; word_index < binary->size; ++word_index) {
+        size_t image_index = 0;
+        for (int d = binary->dimensions; d >= 2; --d)
+            image_index += image->offset[d] * ((word_index / binary->offset[d]) % binary->shape[d]);
+
+        int x0 = (word_index % row_words) * BINARY_WORD_BITS;
+        int bits = std::min(BINARY_WORD_BITS, binary->shape[1] - x0);
+
+        uint64_t word = 0;
+        for (int b = 0; b < bits; ++b)
+            if (image->data[image_index + (x0 + b) * image->offset[1]] > threshold)
+                word |= uint64_t(1) << b;
+
+        binary->data[word_index] = word;
+    }
+
+    return binary;
+}
+
+template<typename T>
+Image<T>* image_from_binary_image(BinaryImage* binary, T max_value)
+{
+    auto image = new Image<T>();
+
+    image->shape = new int[binary->dimensions + 1];
+    image->offset = new int[binary->dimensions + 1];
+    image->dimensions = binary->dimensions;
+
+    std::copy_n(binary->shape, binary->dimensions + 1, image->shape);
+    image->offset[0] = 1;
+    image->size = image->shape[0];
+    for (int d = 1; d <= image->dimensions; ++d) {
+        image->offset[d] = image->size;
+        image->size *= image->shape[d];
+    }
+
+    image->data = new T[image->size]();
+
+    auto row_words = binary->dimensions > 1 ? binary->offset[2] : binary->size;
+    for (size_t word_index = 0; word_index < binary->size; ++word_index) {
+        size_t image_index = 0;
+        for (int d = binary->dimensions; d >= 2; --d)
+            image_index += image->offset[d] * ((word_index / binary->offset[d]) % binary->shape[d]);
+
+        int x0 = (word_index % row_words) * BINARY_WORD_BITS;
+        int bits = std::min(BINARY_WORD_BITS, binary->shape[1] - x0);
+
+        for (int b = 0; b < bits; ++b)
+            if ((binary->data[word_index] >> b) & 1)
+                image->data[image_index + (x0 + b) * image->offset[1]] = max_value;
+    }
+
+    return image;
+}
+
+void binary_image_destroy(BinaryImage* binary)
+{
+    delete[] binary->data;
+    delete[] binary->shape;
+    delete[] binary->offset;
+    delete binary;
+}
+
+// Morton order over the low brick coordinate bits, row-major blocks above them
+template<typename T>
+BrickedImage<T>* bricked_image_similar_from_image(Image<T>* image, BrickOrder order)
+{
+    auto bricked = new BrickedImage<T>();
+    auto dimensions = image->dimensions;
+    auto edge = brick_edge(dimensions);
+    int edge_bits = std::countr_zero(unsigned(edge));
+
+    bricked->shape = new int[dimensions + 1];
+    bricked->offset = new int[dimensions + 1];
+    bricked->table_offset = new int[dimensions + 1];
+    bricked->dimensions = dimensions;
+    bricked->size = image->size;
+
+    std::copy_n(image->shape, dimensions + 1, bricked->shape);
+    std::copy_n(image->offset, dimensions + 1, bricked->offset);
+
+    int table_size = 0;
+    for (int d = 1; d <= dimensions; ++d) {
+        bricked->table_offset[d] = table_size;
+        table_size += image->shape[d];
+    }
+    bricked->table = new size_t[table_size];
+
+    size_t brick_size = 1;
+    int grid[VGL_ARR_SHAPE_SIZE];
+    int grid_bits[VGL_ARR_SHAPE_SIZE];
+    int blocks[VGL_ARR_SHAPE_SIZE];
+    for (int d = 1; d <= dimensions; ++d) {
+        brick_size *= edge;
+        grid[d] = (image->shape[d] + edge - 1) / edge;
+        grid_bits[d] = std::bit_width(unsigned(grid[d] - 1));
+        while (grid_bits[d] > 0 && 8 * ((((grid[d] - 1) >> grid_bits[d]) + 1) << grid_bits[d]) > 9 * grid[d])
+            --grid_bits[d];
+        blocks[d] = ((grid[d] - 1) >> grid_bits[d]) + 1;
+    }
+
+    // Output bit of every brick coordinate bit, assigned round-robin over the axes that still have bits left
+    int grid_bit_position[VGL_ARR_SHAPE_SIZE][32];
+    int position = 0;
+    for (int bit = 0; bit < 32; ++bit)
+        for (int d = 1; d <= dimensions; ++d)
+            if (bit < grid_bits[d])
+                grid_bit_position[d][bit] = position++;
+
+    size_t grid_stride = 1;
+    size_t block_stride = size_t(1) << position;
+    size_t edge_stride = 1;
+    for (int d = 1; d <= dimensions; ++d) {
+        for (int c = 0; c < image->shape[d]; ++c) {
+            size_t brick = c / edge;
+            size_t voxel = c % edge;
+            size_t brick_index = 0;
+            size_t voxel_index = 0;
+
+            if (order == BrickOrder::ROW_MAJOR) {
+                brick_index = brick * grid_stride;
+                voxel_index = voxel * edge_stride;
+            } else {
+                brick_index = (brick >> grid_bits[d]) * block_stride;
+                for (int bit = 0; bit < grid_bits[d]; ++bit)
+                    brick_index |= (brick >> bit & 1) << grid_bit_position[d][bit];
+                for (int bit = 0; bit < edge_bits; ++bit)
+                    voxel_index |= (voxel >> bit & 1) << (bit * dimensions + d - 1);
+            }
+
+            bricked->table[bricked->table_offset[d] + c] = brick_index * brick_size + voxel_index;
+        }
+        grid_stride *= grid[d];
+        block_stride *= blocks[d];
+        edge_stride *= edge;
+    }
+
+    bricked->capacity = brick_size * (order == BrickOrder::ROW_MAJOR ? grid_stride : block_stride);
+    bricked->data = new T[bricked->capacity];
+
+    return bricked;
+}
+
+template<typename T>
+BrickedImage<T>* bricked_image_from_image(Image<T>* image, BrickOrder order)
+{
+    auto bricked = bricked_image_similar_from_image(image, order);
+
+    for (size_t i = 0; i < image->size; ++i) {
+        size_t position = 0;
+        for (int d = 1; d <= image->dimensions; ++d)
+            position += bricked->table[bricked->table_offset[d] + i / image->offset[d] % image->shape[d]];
+        bricked->data[position] = image->data[i];
+    }
+
+    return bricked;
+}
+
+template<typename T>
+void bricked_image_destroy(BrickedImage<T>* bricked)
+{
+    delete[] bricked->data;
+    delete[] bricked->shape;
+    delete[] bricked->offset;
+    delete[] bricked->table;
+    delete[] bricked->table_offset;
+    delete bricked;
+}
+
+// Corners of the image cropped to edge voxels, shifted along the last axis so that the volumes differ
+template<typename T>
+Image<T>* image_batch_from_image(Image<T>* image, int edge, int count)
+{
+    auto batch = new Image<T>();
+
+    batch->shape = new int[image->dimensions + 2];
+    batch->offset = new int[image->dimensions + 2];
+    batch->dimensions = image->dimensions + 1;
+
+    batch->shape[0] = image->shape[0];
+    batch->offset[0] = 1;
+    batch->size = 1;
+    for (int d = 1; d <= image->dimensions; ++d) {
+        batch->shape[d] = std::min(edge, image->shape[d]);
+        batch->offset[d] = batch->size;
+        batch->size *= batch->shape[d];
+    }
+    batch->shape[batch->dimensions] = count;
+    batch->offset[batch->dimensions] = batch->size;
+    batch->size *= count;
+
+    batch->data = new T[batch->size];
+
+    auto volume_size = batch->offset[batch->dimensions];
+    auto shifts = image->shape[image->dimensions] - batch->shape[image->dimensions] + 1;
+    for (int b = 0; b < count; ++b) {
+        for (int v = 0; v < volume_size; ++v) {
+            size_t index = size_t(b % shifts) * image->offset[image->dimensions];
+            for (int d = 1; d <= image->dimensions; ++d)
+                index += size_t(v / batch->offset[d] % batch->shape[d]) * image->offset[d];
+            batch->data[size_t(b) * volume_size + v] = image->data[index];
+        }
+    }
+
+    return batch;
+}
+
+template<typename T>
+LabelImage* label_image_similar_from_image(Image<T>* image)
+{
+    auto labels = new LabelImage();
+
+    labels->data = new uint32_t[image->size];
+    labels->shape = new int[image->dimensions + 1];
+    labels->offset = new int[image->dimensions + 1];
+    labels->dimensions = image->dimensions;
+    labels->size = image->size;
+
+    std::copy_n(image->shape, image->dimensions + 1, labels->shape);
+    std::copy_n(image->offset, image->dimensions + 1, labels->offset);
+
+    return labels;
+}
+
+// Spread labels over the non-zero gray levels so touching components stay distinguishable
+void label_image_to_vglimage(LabelImage* labels, VglImage* vglimage)
+{
+    std::transform(labels->data, labels->data + labels->size, vglimage->getImageData(), [](uint32_t label) {
+        return label == 0 ? uint8_t(0) : uint8_t(1 + label % 255);
+    });
+}
+
+// Distances are stored in voxels, saturate them at the brightest gray level
+void distance_image_to_vglimage(Image<float>* distances, VglImage* vglimage)
+{
+    std::transform(distances->data, distances->data + distances->size, vglimage->getImageData(), [](float distance) {
+        return uint8_t(std::min(distance, 255.0f));
+    });
+}
+
+#define INSTANTIATE_IMAGE(T)                                                                          \
+    template Image<T>* image_from_vglimage<T>(VglImage* vglimage);                                    \
+    template Image<T>* image_convert_from_vglimage<T>(VglImage* vglimage);                            \
+    template void image_to_vglimage<T>(Image<T>* image, VglImage* vglimage);                          \
+    template Image<T>* image_similar_from_image<T>(Image<T>* image);                                  \
+    template Image<T>* image_cast<T, uint8_t>(Image<uint8_t>* image);                                 \
+    template Image<T>* image_cast<T, uint16_t>(Image<uint16_t>* image);                               \
+    template Image<T>* image_cast<T, float>(Image<float>* image);                                     \
+    template void image_destroy<T>(Image<T>* image);                                                  \
+    template BinaryImage* binary_image_similar_from_image<T>(Image<T>* image);                        \
+    template BinaryImage* binary_image_from_image<T>(Image<T>* image, T threshold);                   \
+    template Image<T>* image_from_binary_image<T>(BinaryImage* binary, T max_value);                  \
+    template LabelImage* label_image_similar_from_image<T>(Image<T>* image);                          \
+    template BrickedImage<T>* bricked_image_similar_from_image<T>(Image<T>* image, BrickOrder order); \
+    template BrickedImage<T>* bricked_image_from_image<T>(Image<T>* image, BrickOrder order);         \
+    template void bricked_image_destroy<T>(BrickedImage<T>* bricked);                                 \
+    template Image<T>* image_batch_from_image<T>(Image<T>* image, int edge, int count);
+
+INSTANTIATE_IMAGE(uint8_t)
+INSTANTIATE_IMAGE(uint16_t)
+INSTANTIATE_IMAGE(float)
+
+template void image_destroy<uint32_t>(LabelImage* image);
+
 Window* window_from_vglstrel(VglStrEl* vglstrel)
 {
     auto window = new Window();
@@ -94,24 +450,642 @@ Window* window_create_from_type(WindowType type, uint8_t dimension)
     }
 }
 
-void BenchmarkBuilder::perform_benchmark(std::size_t rounds, BenchmarkSpec const& spec)
+Window* window_create_axis_from_type(WindowType type, uint8_t dimension, uint8_t axis)
 {
-    // Warm up
-    spec.func();
+    int shape[VGL_ARR_SHAPE_SIZE];
+    for (int i = 0; i < VGL_ARR_SHAPE_SIZE; ++i)
+        shape[i] = 1;
+    shape[axis] = 3;
 
-    for (size_t i = 0; i < rounds; ++i)
+    float data_cube[3] = { 1.0f, 1.0f, 1.0f };
+    float data_mean[3] = { 1.0f / 3.0f, 1.0f / 3.0f, 1.0f / 3.0f };
+
+    auto vglshape = VglShape(shape, dimension);
+    switch (type) {
+    case WindowType::CROSS:
+    case WindowType::CUBE:
+        return window_convert_from_vglstrel(new VglStrEl(data_cube, &vglshape));
+    case WindowType::MEAN:
+        return window_convert_from_vglstrel(new VglStrEl(data_mean, &vglshape));
+    default:
+        return new Window();
+    }
+}
+
+// Sampled up to three standard deviations on each side and normalized to unit sum
+Window* window_create_gaussian_axis(float sigma, uint8_t dimension, uint8_t axis)
+{
+    int radius = int(std::ceil(3.0f * sigma));
+
+    int shape[VGL_ARR_SHAPE_SIZE];
+    for (int i = 0; i < VGL_ARR_SHAPE_SIZE; ++i)
+        shape[i] = 1;
+    shape[axis] = 2 * radius + 1;
+
+    auto data = std::vector<float>(2 * radius + 1);
+    for (int i = -radius; i <= radius; ++i)
+        data[i + radius] = std::exp(-0.5f * i * i / (sigma * sigma));
+    auto sum = std::accumulate(data.begin(), data.end(), 0.0f);
+    for (auto& value : data)
+        value /= sum;
+
+    auto vglshape = VglShape(shape, dimension);
+    return window_convert_from_vglstrel(new VglStrEl(data.data(), &vglshape));
+}
+
+// Dense product of the sampled axis Gaussians, normalized to unit sum
+Window* window_create_gaussian(float sigma, uint8_t dimension)
+{
+    int radius = int(std::ceil(3.0f * sigma));
+
+    int shape[VGL_ARR_SHAPE_SIZE];
+    for (int i = 0; i < VGL_ARR_SHAPE_SIZE; ++i)
+        shape[i] = 1;
+    for (int d = 1; d <= dimension; ++d)
+        shape[d] = 2 * radius + 1;
+
+    auto vglshape = VglShape(shape, dimension);
+    auto data = std::vector<float>(vglshape.getSize());
+    for (size_t i = 0; i < data.size(); ++i) {
+        float squared = 0.0f;
+        int rest = i;
+        for (int d = 1; d <= dimension; ++d) {
+            int x = rest % shape[d] - radius;
+            rest /= shape[d];
+            squared += x * x;
+        }
+        data[i] = std::exp(-0.5f * squared / (sigma * sigma));
+    }
+    auto sum = std::accumulate(data.begin(), data.end(), 0.0f);
+    for (auto& value : data)
+        value /= sum;
+
+    return window_convert_from_vglstrel(new VglStrEl(data.data(), &vglshape));
+}
+
+// Entries whose neighbor one step along the axis falls outside the window, the trailing edge of a slide
+Window* window_create_edge_from_window(Window* window, uint8_t axis, int step)
+{
+    auto edge = new Window();
+
+    edge->data = new float[window->size];
+    edge->shape = new int[window->dimensions + 1];
+    edge->offset = new int[window->dimensions + 1];
+    edge->dimensions = window->dimensions;
+    edge->size = window->size;
+
+    std::copy_n(window->shape, window->dimensions + 1, edge->shape);
+    std::copy_n(window->offset, window->dimensions + 1, edge->offset);
+
+    for (size_t i = 0; i < window->size; ++i) {
+        int coord = i / window->offset[axis] % window->shape[axis] + step;
+        bool inside = coord >= 0 && coord < window->shape[axis] && window->data[i + step * window->offset[axis]] != 0;
+        edge->data[i] = window->data[i] != 0 && !inside ? 1.0f : 0.0f;
+    }
+
+    return edge;
+}
+
+size_t window_count(Window* window)
+{
+    return std::count_if(window->data, window->data + window->size, [](float value) { return value != 0; });
+}
+
+bool window_symmetric(Window* window)
+{
+    for (int d = 1; d <= window->dimensions; ++d)
+        if (window->shape[d] % 2 == 0)
+            return false;
+
+    return std::equal(window->data, window->data + window->size / 2, std::reverse_iterator(window->data + window->size));
+}
+
+Window* window_batch_from_window(Window* window, uint8_t batch_dimension)
+{
+    auto batch = new Window();
+
+    batch->data = new float[window->size];
+    batch->shape = new int[window->dimensions + batch_dimension + 1];
+    batch->offset = new int[window->dimensions + batch_dimension + 1];
+    batch->dimensions = window->dimensions + batch_dimension;
+    batch->size = window->size;
+
+    std::copy_n(window->data, window->size, batch->data);
+    std::copy_n(window->shape, window->dimensions + 1, batch->shape);
+    std::copy_n(window->offset, window->dimensions + 1, batch->offset);
+    for (int d = window->dimensions + 1; d <= batch->dimensions; ++d) {
+        batch->shape[d] = 1;
+        batch->offset[d] = window->size;
+    }
+
+    return batch;
+}
+
+static Window* window_create_from_predicate(int const* radii, uint8_t dimension, std::function<bool(int const*)> inside)
+{
+    int shape[VGL_ARR_SHAPE_SIZE];
+    for (int i = 0; i < VGL_ARR_SHAPE_SIZE; ++i)
+        shape[i] = 1;
+    for (int d = 1; d <= dimension; ++d)
+        shape[d] = 2 * radii[d] + 1;
+
+    auto vglshape = VglShape(shape, dimension);
+    auto data = std::vector<float>(vglshape.getSize());
+
+    int coord[VGL_ARR_SHAPE_SIZE];
+    for (size_t i = 0; i < data.size(); ++i) {
+        for (int d = 1; d <= dimension; ++d)
+            coord[d] = int(i / vglshape.getOffset()[d] % shape[d]) - radii[d];
+        data[i] = inside(coord) ? 1.0f : 0.0f;
+    }
+
+    return window_convert_from_vglstrel(new VglStrEl(data.data(), &vglshape));
+}
+
+static void strel_radii(StrelType type, int const* radii, uint8_t dimension, int* strel_radii)
+{
+    for (int d = 1; d <= dimension; ++d)
+        strel_radii[d] = type == StrelType::ELLIPSOID ? radii[d] : radii[1];
+}
+
+static bool strel_inside(StrelType type, int const* radii, uint8_t dimension, int const* coord)
+{
+    double sum = 0;
+    for (int d = 1; d <= dimension; ++d)
+        if (type == StrelType::DIAMOND)
+            sum += std::abs(coord[d]) / double(radii[d]);
+        else
+            sum += coord[d] * coord[d] / (double(radii[d]) * radii[d]);
+
+    return sum <= 1.0 + 1e-9;
+}
+
+// Shape of k cross passes and a line per axis, voxels within k unit steps of the lines
+static bool strel_decomposed_inside(int k, int const* radii, uint8_t dimension, int const* coord)
+{
+    int steps = 0;
+    for (int d = 1; d <= dimension; ++d)
+        steps += std::max(0, std::abs(coord[d]) - (radii[d] - k));
+
+    return steps <= k;
+}
+
+Window* window_create_strel(StrelType type, int const* radii, uint8_t dimension)
+{
+    int r[VGL_ARR_SHAPE_SIZE];
+    strel_radii(type, radii, dimension, r);
+
+    return window_create_from_predicate(r, dimension, [&](int const* coord) { return strel_inside(type, r, dimension, coord); });
+}
+
+Window* window_create_line(uint8_t dimension, uint8_t axis, int radius)
+{
+    int radii[VGL_ARR_SHAPE_SIZE] = { 0 };
+    radii[axis] = radius;
+
+    return window_create_from_predicate(radii, dimension, [](int const*) { return true; });
+}
+
+// Crosses followed by a line per axis, kept only where they rebuild the requested shape exactly
+StrelPlan* strel_plan_create(StrelType type, int const* radii, uint8_t dimension)
+{
+    int r[VGL_ARR_SHAPE_SIZE];
+    strel_radii(type, radii, dimension, r);
+
+    int shape[VGL_ARR_SHAPE_SIZE];
+    for (int i = 0; i < VGL_ARR_SHAPE_SIZE; ++i)
+        shape[i] = 1;
+    for (int d = 1; d <= dimension; ++d)
+        shape[d] = 2 * r[d] + 1;
+    auto vglshape = VglShape(shape, dimension);
+
+    int min_radius = *std::min_element(r + 1, r + dimension + 1);
+    int best_k = 0;
+    size_t best_difference = SIZE_MAX;
+    int coord[VGL_ARR_SHAPE_SIZE];
+    for (int k = 0; k <= min_radius; ++k) {
+        size_t difference = 0;
+        for (int i = 0; i < vglshape.getSize(); ++i) {
+            for (int d = 1; d <= dimension; ++d)
+                coord[d] = i / vglshape.getOffset()[d] % shape[d] - r[d];
+            difference += strel_inside(type, r, dimension, coord) != strel_decomposed_inside(k, r, dimension, coord);
+        }
+        if (difference < best_difference) {
+            best_difference = difference;
+            best_k = k;
+        }
+    }
+
+    auto plan = new StrelPlan();
+    plan->window = window_create_strel(type, radii, dimension);
+    if (best_difference != 0)
+        return plan;
+
+    for (int k = 0; k < best_k; ++k)
+        plan->steps.push_back(window_create_from_type(WindowType::CROSS, dimension));
+    for (int d = 1; d <= dimension; ++d)
+        if (r[d] > best_k)
+            plan->steps.push_back(window_create_line(dimension, d, r[d] - best_k));
+
+    size_t decomposed_cost = 0;
+    for (auto step : plan->steps)
+        decomposed_cost += window_count(step) + STREL_PASS_COST;
+
+    if (decomposed_cost >= window_count(plan->window) + STREL_PASS_COST) {
+        for (auto step : plan->steps)
+            window_destroy(step);
+        plan->steps.clear();
+    }
+
+    return plan;
+}
+
+void strel_plan_destroy(StrelPlan* plan)
+{
+    window_destroy(plan->window);
+    for (auto step : plan->steps)
+        window_destroy(step);
+    delete plan;
+}
+
+PipelinePlan* pipeline_plan_create(std::vector<PipelineStep> const& steps)
+{
+    auto images = 1;
+    for (auto const& step : steps)
+        images = std::max(images, step.output + 1);
+
+    // An image is live from the step writing it to the last step reading it, the chain result until the end
+    auto last_use = std::vector<size_t>(images, 0);
+    for (size_t s = 0; s < steps.size(); ++s) {
+        last_use[steps[s].input] = s;
+        last_use[steps[s].output] = s;
+    }
+    if (!steps.empty())
+        last_use[steps.back().output] = steps.size();
+
+    auto plan = new PipelinePlan { .buffers = std::vector<int>(images, 0), .count = 1 };
+    auto released = std::vector<int>();
+    for (size_t s = 0; s < steps.size(); ++s) {
+        auto const& step = steps[s];
+        auto input_ends = step.input != 0 && last_use[step.input] == s;
+
+        if (step.point && input_ends) {
+            plan->buffers[step.output] = plan->buffers[step.input];
+        } else {
+            // Window operators read neighbors, so their input is released after the output got a buffer
+            if (released.empty()) {
+                plan->buffers[step.output] = plan->count++;
+            } else {
+                plan->buffers[step.output] = released.back();
+                released.pop_back();
+            }
+            if (input_ends)
+                released.push_back(plan->buffers[step.input]);
+        }
+
+        if (last_use[step.output] == s)
+            released.push_back(plan->buffers[step.output]);
+    }
+
+    return plan;
+}
+
+void pipeline_plan_destroy(PipelinePlan* plan)
+{
+    delete plan;
+}
+
+namespace {
+
+struct AtomicMemoryCounters {
+    std::atomic<size_t> allocations;
+    std::atomic<size_t> bytes;
+    std::atomic<size_t> live;
+    std::atomic<size_t> peak;
+
+    void allocate(size_t size)
     {
-        auto start = std::chrono::high_resolution_clock::now();
-        spec.func();
-        auto end = std::chrono::high_resolution_clock::now();
-        std::cout
-            << spec.name << ","
-            << spec.type << ","
-            << spec.group << ","
-            << std::chrono::duration<double>(end - start).count() << "\n";
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+        auto current = live.fetch_add(size, std::memory_order_relaxed) + size;
+        auto highest = peak.load(std::memory_order_relaxed);
+        while (current > highest && !peak.compare_exchange_weak(highest, current, std::memory_order_relaxed)) { }
+    }
+
+    void free(size_t size)
+    {
+        live.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    MemoryCounters load() const
+    {
+        return { allocations.load(), bytes.load(), live.load(), peak.load() };
     }
+};
+
+constinit AtomicMemoryCounters host_counters {};
+constinit AtomicMemoryCounters device_counters {};
+
+// Device pointers are opaque to the host, so their sizes are remembered until they are freed
+std::unordered_map<void*, size_t>& device_allocations()
+{
+    static auto allocations = std::unordered_map<void*, size_t>();
+    return allocations;
+}
+std::mutex device_allocations_mutex;
+
+// Every host block starts with its size so that unsized deletes can be accounted for
+constexpr size_t ALLOCATION_HEADER = alignof(std::max_align_t);
+
+void* host_allocate(size_t size)
+{
+    auto base = static_cast<char*>(std::malloc(size + ALLOCATION_HEADER));
+    if (base == nullptr)
+        return nullptr;
+
+    *reinterpret_cast<size_t*>(base) = size;
+    host_counters.allocate(size);
+
+    return base + ALLOCATION_HEADER;
+}
+
+void host_free(void* pointer)
+{
+    if (pointer == nullptr)
+        return;
+
+    auto base = static_cast<char*>(pointer) - ALLOCATION_HEADER;
+    host_counters.free(*reinterpret_cast<size_t*>(base));
+    std::free(base);
+}
+
+} // namespace
+
+void* operator new(size_t size)
+{
+    auto pointer = host_allocate(size);
+    if (pointer == nullptr)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, std::nothrow_t const&) noexcept
+{
+    return host_allocate(size);
+}
+
+void* operator new[](size_t size, std::nothrow_t const&) noexcept
+{
+    return host_allocate(size);
+}
+
+void operator delete(void* pointer) noexcept
+{
+    host_free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    host_free(pointer);
+}
 
-    if (spec.post != nullptr)
+void operator delete(void* pointer, size_t) noexcept
+{
+    host_free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    host_free(pointer);
+}
+
+void operator delete(void* pointer, std::nothrow_t const&) noexcept
+{
+    host_free(pointer);
+}
+
+void operator delete[](void* pointer, std::nothrow_t const&) noexcept
+{
+    host_free(pointer);
+}
+
+MemoryUsage memory_usage()
+{
+    auto usage = MemoryUsage {
+        .host = host_counters.load(),
+        .device = device_counters.load(),
+        .resident = 0,
+    };
+
+    // Resident pages are the second field of statm, read into the stack to stay out of the host counters
+    char statm[128];
+    size_t pages = 0;
+    if (auto fd = open("/proc/self/statm", O_RDONLY); fd >= 0) {
+        auto length = read(fd, statm, sizeof(statm) - 1);
+        close(fd);
+        statm[std::max<ssize_t>(length, 0)] = '\0';
+        if (std::sscanf(statm, "%zu %zu", &pages, &usage.resident) == 2)
+            usage.resident *= sysconf(_SC_PAGESIZE);
+        else
+            usage.resident = 0;
+    }
+
+    return usage;
+}
+
+void memory_reset_peak()
+{
+    host_counters.peak.store(host_counters.live.load());
+    device_counters.peak.store(device_counters.live.load());
+}
+
+void memory_track_device_allocation(void* pointer, size_t bytes)
+{
+    if (pointer == nullptr)
+        return;
+
+    auto lock = std::lock_guard(device_allocations_mutex);
+    device_allocations()[pointer] = bytes;
+    device_counters.allocate(bytes);
+}
+
+void memory_track_device_free(void* pointer)
+{
+    auto lock = std::lock_guard(device_allocations_mutex);
+    if (auto allocation = device_allocations().find(pointer); allocation != device_allocations().end()) {
+        device_counters.free(allocation->second);
+        device_allocations().erase(allocation);
+    }
+}
+
+int fft_length(int size)
+{
+    for (int length = std::max(size, 1);; ++length) {
+        int rest = length;
+        for (auto radix : FFT_RADICES)
+            while (rest % radix == 0)
+                rest /= radix;
+        if (rest == 1)
+            return length;
+    }
+}
+
+FftPlan* fft_plan_create(int const* shape, uint8_t dimension, Window* window)
+{
+    auto plan = new FftPlan();
+
+    plan->shape = new int[dimension + 1];
+    plan->offset = new int[dimension + 1];
+    plan->valid = new int[dimension + 1];
+    plan->grid = new int[dimension + 1];
+    plan->anchor = new int[dimension + 1];
+    plan->radix_offset = new int[dimension + 2];
+    plan->twiddle_offset = new int[dimension + 2];
+    plan->dimensions = dimension;
+
+    // Longer axes are cut into tiles whose valid part stays at least three quarters of the tile
+    int edge = 1;
+    while (std::pow(edge + 1, dimension) <= FFT_TILE_SIZE)
+        ++edge;
+
+    auto radices = std::vector<int>();
+    plan->shape[0] = 1;
+    plan->offset[0] = 1;
+    plan->size = 1;
+    plan->tiles = 1;
+    plan->radix_offset[1] = 0;
+    plan->twiddle_offset[1] = 0;
+    for (int d = 1; d <= dimension; ++d) {
+        int extent = window->shape[d];
+        int tile = std::max(edge, 4 * (extent - 1));
+
+        plan->shape[d] = fft_length(std::min(shape[d] + extent - 1, tile));
+        plan->offset[d] = plan->size;
+        plan->valid[d] = plan->shape[d] - extent + 1;
+        plan->grid[d] = (shape[d] + plan->valid[d] - 1) / plan->valid[d];
+        plan->anchor[d] = (extent - 1) / 2;
+        plan->size *= plan->shape[d];
+        plan->tiles *= plan->grid[d];
+
+        for (int rest = plan->shape[d]; rest > 1;)
+            for (auto radix : FFT_RADICES)
+                if (rest % radix == 0) {
+                    radices.push_back(radix);
+                    rest /= radix;
+                    break;
+                }
+        plan->radix_offset[d + 1] = radices.size();
+        plan->twiddle_offset[d + 1] = plan->twiddle_offset[d] + plan->shape[d];
+    }
+    plan->pairs = (plan->tiles + 1) / 2;
+    plan->batch = std::clamp(FFT_BATCH_SIZE / plan->size, size_t(1), plan->pairs);
+
+    plan->radices = new int[radices.size()];
+    std::copy(radices.begin(), radices.end(), plan->radices);
+
+    plan->twiddles = new float[2 * plan->twiddle_offset[dimension + 1]];
+    for (int d = 1; d <= dimension; ++d)
+        for (int m = 0; m < plan->shape[d]; ++m) {
+            double angle = 2.0 * std::numbers::pi * m / plan->shape[d];
+            plan->twiddles[2 * (plan->twiddle_offset[d] + m)] = float(std::cos(angle));
+            plan->twiddles[2 * (plan->twiddle_offset[d] + m) + 1] = float(-std::sin(angle));
+        }
+
+    // Conjugated and prescaled, so the product is a correlation that needs no normalization
+    plan->spectrum = new float[2 * plan->size]();
+    for (size_t i = 0; i < window->size; ++i) {
+        size_t index = 0;
+        for (int d = 1; d <= dimension; ++d)
+            index += size_t(i / window->offset[d] % window->shape[d]) * plan->offset[d];
+        plan->spectrum[2 * index] = window->data[i];
+    }
+
+    auto scratch = std::vector<float>(2 * plan->size);
+    for (int d = 1; d <= dimension; ++d) {
+        size_t stride = plan->offset[d];
+        for (size_t line = 0; line < plan->size / plan->shape[d]; ++line) {
+            size_t base = line / stride * stride * plan->shape[d] + line % stride;
+            fft_line(plan->spectrum + 2 * base, scratch.data() + 2 * base, stride, plan->shape[d], plan->radices + plan->radix_offset[d],
+                plan->radix_offset[d + 1] - plan->radix_offset[d], plan->twiddles + 2 * plan->twiddle_offset[d], false);
+        }
+    }
+    for (size_t i = 0; i < plan->size; ++i) {
+        plan->spectrum[2 * i] /= plan->size;
+        plan->spectrum[2 * i + 1] /= -float(plan->size);
+    }
+
+    return plan;
+}
+
+void fft_plan_destroy(FftPlan* plan)
+{
+    delete[] plan->shape;
+    delete[] plan->offset;
+    delete[] plan->valid;
+    delete[] plan->grid;
+    delete[] plan->anchor;
+    delete[] plan->radices;
+    delete[] plan->radix_offset;
+    delete[] plan->twiddles;
+    delete[] plan->twiddle_offset;
+    delete[] plan->spectrum;
+    delete plan;
+}
+
+// Radix p stages read p values per output, every direct tap clamps and indexes along every axis
+bool fft_plan_preferred(FftPlan* plan, Window* window, size_t size)
+{
+    size_t stage_cost = 3;
+    for (int d = 1; d <= plan->dimensions; ++d)
+        for (int r = plan->radix_offset[d]; r < plan->radix_offset[d + 1]; ++r)
+            stage_cost += 2 * plan->radices[r];
+
+    return FFT_STAGE_COST * plan->pairs * plan->size * stage_cost < float(size) * window_count(window) * plan->dimensions;
+}
+
+static std::string report_lead;
+
+void benchmark_report_lead(std::string columns)
+{
+    report_lead = columns;
+}
+
+void BenchmarkBuilder::perform_round(std::size_t round, BenchmarkSpec const& spec)
+{
+    // Memory columns include the warm-up of the first round
+    memory_reset_peak();
+    auto before = memory_usage();
+
+    // Warm up
+    if (round == 0)
+        spec.func();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    spec.func();
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration<double>(end - start).count();
+
+    auto after = memory_usage();
+    std::cout
+        << report_lead
+        << spec.name << ","
+        << spec.type << ","
+        << spec.group << ","
+        << duration << ","
+        << after.host.allocations - before.host.allocations << ","
+        << after.host.bytes - before.host.bytes << ","
+        << after.host.peak - before.host.live << ","
+        << after.device.allocations - before.device.allocations << ","
+        << after.device.bytes - before.device.bytes << ","
+        << after.device.peak - before.device.live << ","
+        << int64_t(after.resident) - int64_t(before.resident) << "\n";
+
+    if (round == 0 && spec.post != nullptr)
         spec.post(spec.name);
 }
 
@@ -120,10 +1094,39 @@ void BenchmarkBuilder::attach(BenchmarkSpec&& spec)
     m_specs.emplace_back(spec);
 }
 
-void BenchmarkBuilder::run(std::size_t rounds)
+void BenchmarkBuilder::run(std::size_t round, bool header)
+{
+    if (round == 0 && header && report_lead.empty())
+        std::cout << BENCHMARK_REPORT_COLUMNS << "\n";
+    for (auto const& spec : m_specs) perform_round(round, spec);
+}
+
+BenchmarkSession::BenchmarkSession(BenchmarkSession&& other) noexcept
+    : m_handle(std::exchange(other.m_handle, nullptr))
+{
+}
+
+BenchmarkSession::~BenchmarkSession()
 {
-    if (rounds < 1) rounds = 1;
+    if (m_handle)
+        m_handle.destroy();
+}
+
+bool BenchmarkSession::run()
+{
+    auto& nested = m_handle.promise().nested;
+    while (!m_handle.done()) {
+        // Suspended ahead of a round of its own specs
+        if (nested == nullptr) {
+            m_handle.resume();
+            return true;
+        }
+
+        if (nested->run())
+            return true;
+        nested.reset();
+        m_handle.resume();
+    }
 
-    std::cout << "operator,type,group,duration\n";
-    for (auto const& spec : m_specs) perform_benchmark(rounds, spec);
+    return false;
 }
@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <functional>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
 
 #include <sycl/sycl.hpp>
 #include <visiongl/constants.hpp>
@@ -10,64 +16,1333 @@
 
 #include <utils.hpp>
 
+template<typename T>
 class Kernel {
 protected:
-    Image* m_input;
-    Image* m_output;
+    Image<T>* m_input;
+    Image<T>* m_output;
 
 public:
-    Kernel(Image* input, Image* output)
+    Kernel(Image<T>* input, Image<T>* output)
         : m_input(input)
         , m_output(output)
     {
     }
 };
 
-class InvertKernel : public Kernel {
+template<typename T>
+class FillKernel {
+private:
+    Image<T>* m_output;
+    T m_value;
+
+public:
+    FillKernel(Image<T>* output, T value)
+        : m_output(output)
+        , m_value(value)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        m_output->data[i] = m_value;
+    }
+};
+
+template<typename T>
+class InvertKernel : public Kernel<T> {
+    using Kernel<T>::m_input;
+    using Kernel<T>::m_output;
+
+public:
+    using Kernel<T>::Kernel;
+
+    void operator()(sycl::id<> i) const
+    {
+        m_output->data[i] = VoxelTraits<T>::max - m_input->data[i];
+    }
+};
+
+template<typename T>
+class ThresholdKernel : public Kernel<T> {
+    using Kernel<T>::m_input;
+    using Kernel<T>::m_output;
+
+private:
+    T m_threshold;
+    T m_max_value;
+
+public:
+    ThresholdKernel(Image<T>* input, Image<T>* output, T threshold, T max_value)
+        : Kernel<T>(input, output)
+        , m_threshold(threshold)
+        , m_max_value(max_value)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        m_output->data[i] = m_input->data[i] > m_threshold ? m_max_value : 0;
+    }
+};
+
+// Reads its level from device memory, e.g. written by OtsuKernel
+template<typename T>
+class DeviceThresholdKernel : public Kernel<T> {
+    using Kernel<T>::m_input;
+    using Kernel<T>::m_output;
+
+private:
+    T const* m_level;
+    T m_max_value;
+
+public:
+    DeviceThresholdKernel(Image<T>* input, Image<T>* output, T const* level, T max_value)
+        : Kernel<T>(input, output)
+        , m_level(level)
+        , m_max_value(max_value)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        m_output->data[i] = m_input->data[i] > *m_level ? m_max_value : 0;
+    }
+};
+
+template<typename T>
+class SubtractKernel : public Kernel<T> {
+    using Kernel<T>::m_input;
+    using Kernel<T>::m_output;
+
+private:
+    Image<T>* m_subtrahend;
+
+public:
+    SubtractKernel(Image<T>* input, Image<T>* subtrahend, Image<T>* output)
+        : Kernel<T>(input, output)
+        , m_subtrahend(subtrahend)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        m_output->data[i] = m_input->data[i] - m_subtrahend->data[i];
+    }
+};
+
+template<typename T>
+class WindowKernel : public Kernel<T> {
+protected:
+    using Kernel<T>::m_input;
+    using Kernel<T>::m_output;
+
+    Window* m_window;
+
+public:
+    WindowKernel(Image<T>* input, Image<T>* output, Window* window)
+        : Kernel<T>(input, output)
+        , m_window(window)
+    {
+    }
+
+    template<typename Func = std::function<void(size_t, size_t)>>
+    inline auto map(size_t index, Func&& apply, bool reflect = false) const
+    {
+        map(m_window, index, apply, reflect);
+    }
+
+    template<typename Func = std::function<void(size_t, size_t)>>
+    inline auto map(Window* window, size_t index, Func&& apply, bool reflect = false) const
+    {
+        int image_coord[VGL_ARR_SHAPE_SIZE];
+        int window_coord[VGL_ARR_SHAPE_SIZE];
+        int ires = index;
+        int idim = 0;
+
+        for (int d = m_input->dimensions; d >= 1; --d) {
+            int off = m_input->offset[d];
+            idim = ires / off;
+            ires = ires - idim * off;
+            image_coord[d] = idim - (window->shape[d] - 1) / 2;
+        }
+
+        size_t image_index = 0;
+        for (size_t window_index = 0; window_index < window->size; ++window_index) {
+            if (window->data[window_index] == 0)
+                continue;
+
+            ires = window_index;
+            image_index = 0;
+
+            for (int d = m_input->dimensions; d > window->dimensions; --d)
+                image_index += m_input->offset[d] * image_coord[d];
+
+            for (int d = window->dimensions; d >= 1; --d) {
+                int off = window->offset[d];
+                idim = ires / off;
+                ires = ires - idim * off;
+                if (reflect)
+                    idim = window->shape[d] - 1 - idim;
+                window_coord[d] = idim + image_coord[d];
+                window_coord[d] = sycl::clamp(window_coord[d], 0, m_input->shape[d] - 1);
+
+                image_index += m_input->offset[d] * window_coord[d];
+            }
+
+            apply(image_index, window_index);
+        }
+    }
+};
+
+template<typename T>
+class ErodeKernel : public WindowKernel<T> {
+    using WindowKernel<T>::m_input;
+    using WindowKernel<T>::m_output;
+    using WindowKernel<T>::map;
+
+public:
+    using WindowKernel<T>::WindowKernel;
+
+    void operator()(sycl::id<> i) const
+    {
+        T pmin = VoxelTraits<T>::max;
+
+        map(i, [&](auto image_index, auto _) {
+            pmin = sycl::min(pmin, m_input->data[image_index]);
+        });
+
+        m_output->data[i] = pmin;
+    }
+};
+
+template<typename T>
+class DilateKernel : public WindowKernel<T> {
+    using WindowKernel<T>::m_input;
+    using WindowKernel<T>::m_output;
+    using WindowKernel<T>::map;
+
+public:
+    using WindowKernel<T>::WindowKernel;
+
+    void operator()(sycl::id<> i) const
+    {
+        T pmax = 0;
+
+        map(i, [&](auto image_index, auto _) {
+            pmax = sycl::max(pmax, m_input->data[image_index]);
+        }, true);
+
+        m_output->data[i] = pmax;
+    }
+};
+
+// Dilation minus erosion from a single sweep over a symmetric window, others sweep it again reflected for the dilation
+template<typename T>
+class GradientKernel : public WindowKernel<T> {
+    using WindowKernel<T>::m_input;
+    using WindowKernel<T>::m_output;
+    using WindowKernel<T>::map;
+
+private:
+    bool m_symmetric;
+
+public:
+    GradientKernel(Image<T>* input, Image<T>* output, Window* window, bool symmetric)
+        : WindowKernel<T>(input, output, window)
+        , m_symmetric(symmetric)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        T pmin = VoxelTraits<T>::max;
+        T pmax = 0;
+
+        map(i, [&](auto image_index, auto _) {
+            pmin = sycl::min(pmin, m_input->data[image_index]);
+            if (m_symmetric)
+                pmax = sycl::max(pmax, m_input->data[image_index]);
+        });
+
+        if (!m_symmetric)
+            map(i, [&](auto image_index, auto _) {
+                pmax = sycl::max(pmax, m_input->data[image_index]);
+            }, true);
+
+        m_output->data[i] = pmax - pmin;
+    }
+};
+
+// Source minus the dilation of an eroded input, the opening is never written out
+template<typename T>
+class WhiteTopHatKernel : public WindowKernel<T> {
+    using WindowKernel<T>::m_input;
+    using WindowKernel<T>::m_output;
+    using WindowKernel<T>::map;
+
+private:
+    Image<T>* m_source;
+
+public:
+    WhiteTopHatKernel(Image<T>* eroded, Image<T>* output, Window* window, Image<T>* source)
+        : WindowKernel<T>(eroded, output, window)
+        , m_source(source)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        T pmax = 0;
+
+        map(i, [&](auto image_index, auto _) {
+            pmax = sycl::max(pmax, m_input->data[image_index]);
+        }, true);
+
+        m_output->data[i] = m_source->data[i] - pmax;
+    }
+};
+
+// Erosion of a dilated input minus source, the closing is never written out
+template<typename T>
+class BlackTopHatKernel : public WindowKernel<T> {
+    using WindowKernel<T>::m_input;
+    using WindowKernel<T>::m_output;
+    using WindowKernel<T>::map;
+
+private:
+    Image<T>* m_source;
+
+public:
+    BlackTopHatKernel(Image<T>* dilated, Image<T>* output, Window* window, Image<T>* source)
+        : WindowKernel<T>(dilated, output, window)
+        , m_source(source)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        T pmin = VoxelTraits<T>::max;
+
+        map(i, [&](auto image_index, auto _) {
+            pmin = sycl::min(pmin, m_input->data[image_index]);
+        });
+
+        m_output->data[i] = pmin - m_source->data[i];
+    }
+};
+
+// Batcher's odd-even merge sort, the sequence of compare-exchanges does not depend on the data
+template<typename T, int N>
+inline void sort_network(T* values)
+{
+    for (int p = 1; p < N; p <<= 1)
+        for (int k = p; k >= 1; k >>= 1)
+            for (int j = k % p; j + k < N; j += 2 * k)
+                for (int i = 0; i < k && i + j + k < N; ++i)
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p)) {
+                        auto low = sycl::min(values[i + j], values[i + j + k]);
+                        auto high = sycl::max(values[i + j], values[i + j + k]);
+                        values[i + j] = low;
+                        values[i + j + k] = high;
+                    }
+}
+
+// Wirth's selection, partially orders values in place until the one at rank is settled
+template<typename T>
+inline T select_rank(T* values, int count, int rank)
+{
+    int low = 0;
+    int high = count - 1;
+    while (low < high) {
+        auto pivot = values[rank];
+        int i = low;
+        int j = high;
+        do {
+            while (values[i] < pivot)
+                ++i;
+            while (pivot < values[j])
+                --j;
+            if (i <= j) {
+                auto swap = values[i];
+                values[i] = values[j];
+                values[j] = swap;
+                ++i;
+                --j;
+            }
+        } while (i <= j);
+
+        if (j < rank)
+            low = i;
+        if (rank < i)
+            high = j;
+    }
+
+    return values[rank];
+}
+
+// Gathers up to N voxels under the window, small windows are padded and sorted by a network
+template<typename T, int N>
+class RankKernel : public WindowKernel<T> {
+    using WindowKernel<T>::m_input;
+    using WindowKernel<T>::m_output;
+    using WindowKernel<T>::map;
+
+private:
+    int m_rank;
+
+public:
+    RankKernel(Image<T>* input, Image<T>* output, Window* window, int rank)
+        : WindowKernel<T>(input, output, window)
+        , m_rank(rank)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        T values[N];
+        int count = 0;
+
+        map(i, [&](auto image_index, auto _) {
+            values[count++] = m_input->data[image_index];
+        });
+
+        if constexpr (N <= RANK_NETWORK_SIZE) {
+            for (int k = count; k < N; ++k)
+                values[k] = VoxelTraits<T>::max;
+            sort_network<T, N>(values);
+            m_output->data[i] = values[m_rank];
+        } else {
+            m_output->data[i] = select_rank(values, count, m_rank);
+        }
+    }
+};
+
+// Huang's sliding histogram along the innermost axis, one work-item per row
+class SlidingRankKernel : public WindowKernel<uint8_t> {
+    using WindowKernel<uint8_t>::m_input;
+    using WindowKernel<uint8_t>::m_output;
+    using WindowKernel<uint8_t>::map;
+
+private:
+    Window* m_leading;
+    Window* m_trailing;
+    int m_rank;
+
+public:
+    SlidingRankKernel(Image<uint8_t>* input, Image<uint8_t>* output, Window* window, Window* leading, Window* trailing, int rank)
+        : WindowKernel<uint8_t>(input, output, window)
+        , m_leading(leading)
+        , m_trailing(trailing)
+        , m_rank(rank)
+    {
+    }
+
+    void operator()(sycl::id<> line) const
+    {
+        int length = m_input->shape[1];
+        size_t base = line * length;
+
+        uint16_t histogram[HISTOGRAM_BINS] = {};
+        int level = 0;
+        int below = 0;
+
+        auto add = [&](auto image_index, auto _) {
+            auto value = m_input->data[image_index];
+            ++histogram[value];
+            below += value < level;
+        };
+        auto remove = [&](auto image_index, auto _) {
+            auto value = m_input->data[image_index];
+            --histogram[value];
+            below -= value < level;
+        };
+
+        map(base, add);
+        for (int x = 0; x < length; ++x) {
+            if (x > 0) {
+                map(m_trailing, base + x - 1, remove);
+                map(m_leading, base + x, add);
+            }
+
+            while (below > m_rank)
+                below -= histogram[--level];
+            while (below + histogram[level] <= m_rank)
+                below += histogram[level++];
+
+            m_output->data[base + x] = level;
+        }
+    }
+};
+
+template<typename T>
+class ConvolveKernel : public WindowKernel<T> {
+    using WindowKernel<T>::m_input;
+    using WindowKernel<T>::m_output;
+    using WindowKernel<T>::m_window;
+    using WindowKernel<T>::map;
+
+public:
+    using WindowKernel<T>::WindowKernel;
+
+    void operator()(sycl::id<> i) const
+    {
+        float result = 0.0f;
+
+        map(i, [&](auto image_index, auto window_index) {
+            result += m_input->data[image_index] * m_window->data[window_index];
+        });
+
+        m_output->data[i] = static_cast<T>(result);
+    }
+};
+
+// Work-groups count into local sub-histograms, one row of partial each
+template<typename T>
+class HistogramKernel {
+private:
+    Image<T>* m_input;
+    uint32_t* m_partial;
+    sycl::local_accessor<uint32_t, 1> m_local;
+
+public:
+    HistogramKernel(Image<T>* input, uint32_t* partial, sycl::local_accessor<uint32_t, 1> local)
+        : m_input(input)
+        , m_partial(partial)
+        , m_local(local)
+    {
+    }
+
+    void operator()(sycl::nd_item<1> item) const
+    {
+        auto local_id = item.get_local_id(0);
+        auto local_range = item.get_local_range(0);
+
+        for (size_t bin = local_id; bin < HISTOGRAM_BINS; bin += local_range)
+            m_local[bin] = 0;
+        sycl::group_barrier(item.get_group());
+
+        for (size_t i = item.get_global_id(0); i < m_input->size; i += item.get_global_range(0)) {
+            auto bin = sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed, sycl::memory_scope::work_group, sycl::access::address_space::local_space>(m_local[voxel_bin(m_input->data[i])]);
+            bin.fetch_add(1);
+        }
+        sycl::group_barrier(item.get_group());
+
+        auto row = m_partial + item.get_group(0) * HISTOGRAM_BINS;
+        for (size_t bin = local_id; bin < HISTOGRAM_BINS; bin += local_range)
+            row[bin] = m_local[bin];
+    }
+};
+
+class HistogramMergeKernel {
+private:
+    uint32_t* m_partial;
+    uint32_t* m_histogram;
+    size_t m_groups;
+
+public:
+    HistogramMergeKernel(uint32_t* partial, uint32_t* histogram, size_t groups)
+        : m_partial(partial)
+        , m_histogram(histogram)
+        , m_groups(groups)
+    {
+    }
+
+    void operator()(sycl::id<> bin) const
+    {
+        uint32_t count = 0;
+        for (size_t group = 0; group < m_groups; ++group)
+            count += m_partial[group * HISTOGRAM_BINS + bin];
+
+        m_histogram[bin] = count;
+    }
+};
+
+template<typename T>
+class OtsuKernel {
+private:
+    uint32_t* m_histogram;
+    T* m_level;
+
+public:
+    OtsuKernel(uint32_t* histogram, T* level)
+        : m_histogram(histogram)
+        , m_level(level)
+    {
+    }
+
+    void operator()() const
+    {
+        *m_level = voxel_from_bin<T>(otsu_threshold(m_histogram));
+    }
+};
+
+template<typename T>
+class StatisticsKernel {
+private:
+    Image<T>* m_input;
+
+public:
+    StatisticsKernel(Image<T>* input)
+        : m_input(input)
+    {
+    }
+
+    template<typename Min, typename Max, typename Sum>
+    void operator()(sycl::id<> i, Min& min, Max& max, Sum& sum) const
+    {
+        auto value = m_input->data[i];
+        min.combine(value);
+        max.combine(value);
+        sum.combine(value);
+    }
+};
+
+template<typename T>
+class MeanKernel {
+private:
+    Statistics<T>* m_statistics;
+    size_t m_size;
+
+public:
+    MeanKernel(Statistics<T>* statistics, size_t size)
+        : m_statistics(statistics)
+        , m_size(size)
+    {
+    }
+
+    void operator()() const
+    {
+        m_statistics->mean = m_statistics->sum / m_size;
+    }
+};
+
+using LabelRef = sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed, sycl::memory_scope::device, sycl::access::address_space::global_space>;
+
+inline uint32_t label_find(uint32_t* labels, uint32_t index)
+{
+    for (auto parent = LabelRef(labels[index]).load(); parent != index + 1; parent = LabelRef(labels[index]).load())
+        index = parent - 1;
+
+    return index;
+}
+
+// Hook the higher root under the lower one, retrying when another work-item relinked it first
+inline void label_union(uint32_t* labels, uint32_t a, uint32_t b)
+{
+    while (true) {
+        a = label_find(labels, a);
+        b = label_find(labels, b);
+        if (a == b)
+            return;
+
+        if (a > b) {
+            auto swap = a;
+            a = b;
+            b = swap;
+        }
+
+        auto parent = LabelRef(labels[b]).fetch_min(a + 1);
+        if (parent == b + 1)
+            return;
+
+        b = parent - 1;
+    }
+}
+
+template<typename T>
+class LabelInitKernel {
+private:
+    Image<T>* m_input;
+    LabelImage* m_labels;
+
+public:
+    LabelInitKernel(Image<T>* input, LabelImage* labels)
+        : m_input(input)
+        , m_labels(labels)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        m_labels->data[i] = m_input->data[i] != 0 ? uint32_t(i) + 1 : 0;
+    }
+};
+
+// Only the window half before the center is visited, the other half is covered by the neighbors themselves
+template<typename T>
+class LabelMergeKernel : public WindowKernel<T> {
+    using WindowKernel<T>::m_input;
+    using WindowKernel<T>::m_window;
+    using WindowKernel<T>::map;
+
+private:
+    LabelImage* m_labels;
+
+public:
+    LabelMergeKernel(Image<T>* input, LabelImage* labels, Window* window)
+        : WindowKernel<T>(input, nullptr, window)
+        , m_labels(labels)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        if (m_input->data[i] == 0)
+            return;
+
+        map(i, [&](auto image_index, auto window_index) {
+            if (window_index < m_window->size / 2 && m_input->data[image_index] != 0)
+                label_union(m_labels->data, i, image_index);
+        });
+    }
+};
+
+class LabelFlattenKernel {
+private:
+    LabelImage* m_labels;
+
+public:
+    LabelFlattenKernel(LabelImage* labels)
+        : m_labels(labels)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        if (LabelRef(m_labels->data[i]).load() != 0)
+            LabelRef(m_labels->data[i]).store(label_find(m_labels->data, i) + 1);
+    }
+};
+
+template<typename T>
+class DistanceInitKernel {
+private:
+    Image<T>* m_input;
+    Image<float>* m_output;
+
+public:
+    DistanceInitKernel(Image<T>* input, Image<float>* output)
+        : m_input(input)
+        , m_output(output)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        m_output->data[i] = m_input->data[i] != 0 ? DISTANCE_INFINITY : 0.0f;
+    }
+};
+
+// One work-item per line builds the lower envelope of its parabolas in scratch laid out like the image
+class DistanceKernel {
+private:
+    Image<float>* m_input;
+    Image<float>* m_output;
+    int* m_vertex;
+    float* m_boundary;
+    int m_axis;
+
+public:
+    DistanceKernel(Image<float>* input, Image<float>* output, int* vertex, float* boundary, int axis)
+        : m_input(input)
+        , m_output(output)
+        , m_vertex(vertex)
+        , m_boundary(boundary)
+        , m_axis(axis)
+    {
+    }
+
+    void operator()(sycl::id<> line) const
+    {
+        size_t stride = m_input->offset[m_axis];
+        int length = m_input->shape[m_axis];
+        size_t base = line / stride * stride * length + line % stride;
+
+        auto f = m_input->data + base;
+        auto v = m_vertex + base;
+        auto z = m_boundary + base;
+
+        int k = 0;
+        v[0] = 0;
+        for (int q = 1; q < length; ++q) {
+            float s;
+            while (true) {
+                int p = v[k * stride];
+                s = ((f[q * stride] + float(q) * q) - (f[p * stride] + float(p) * p)) / (2.0f * (q - p));
+                if (k == 0 || s > z[k * stride])
+                    break;
+                --k;
+            }
+            ++k;
+            v[k * stride] = q;
+            z[k * stride] = s;
+        }
+
+        int last = k;
+        k = 0;
+        for (int q = 0; q < length; ++q) {
+            while (k < last && z[(k + 1) * stride] < q)
+                ++k;
+            int p = v[k * stride];
+            m_output->data[base + q * stride] = float(q - p) * (q - p) + f[p * stride];
+        }
+    }
+};
+
+class DistanceRootKernel {
+private:
+    Image<float>* m_input;
+    Image<float>* m_output;
+
+public:
+    DistanceRootKernel(Image<float>* input, Image<float>* output)
+        : m_input(input)
+        , m_output(output)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        m_output->data[i] = sycl::sqrt(m_input->data[i]);
+    }
+};
+
+// Causal pass into the output, anti-causal pass over it in place, borders replicated
+template<typename T>
+class GaussianKernel {
+private:
+    Image<T>* m_input;
+    Image<float>* m_output;
+    GaussianCoefficients m_coefficients;
+    int m_axis;
+
+public:
+    GaussianKernel(Image<T>* input, Image<float>* output, GaussianCoefficients coefficients, int axis)
+        : m_input(input)
+        , m_output(output)
+        , m_coefficients(coefficients)
+        , m_axis(axis)
+    {
+    }
+
+    void operator()(sycl::id<> line) const
+    {
+        size_t stride = m_input->offset[m_axis];
+        int length = m_input->shape[m_axis];
+        size_t base = line / stride * stride * length + line % stride;
+
+        auto x = m_input->data + base;
+        auto y = m_output->data + base;
+        auto [b, a1, a2, a3] = m_coefficients;
+
+        float w1 = x[0];
+        float w2 = w1;
+        float w3 = w1;
+        for (int n = 0; n < length; ++n) {
+            float w = b * x[n * stride] + a1 * w1 + a2 * w2 + a3 * w3;
+            y[n * stride] = w;
+            w3 = w2;
+            w2 = w1;
+            w1 = w;
+        }
+
+        w2 = w1;
+        w3 = w1;
+        for (int n = length - 1; n >= 0; --n) {
+            float w = b * y[n * stride] + a1 * w1 + a2 * w2 + a3 * w3;
+            y[n * stride] = w;
+            w3 = w2;
+            w2 = w1;
+            w1 = w;
+        }
+    }
+};
+
+template<typename T>
+class RoundKernel {
+private:
+    Image<float>* m_input;
+    Image<T>* m_output;
+
+public:
+    RoundKernel(Image<float>* input, Image<T>* output)
+        : m_input(input)
+        , m_output(output)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        if constexpr (std::is_floating_point_v<T>)
+            m_output->data[i] = m_input->data[i];
+        else
+            m_output->data[i] = T(sycl::clamp(m_input->data[i] + 0.5f, 0.0f, float(VoxelTraits<T>::max)));
+    }
+};
+
+// One work-item per voxel of a chunk of tile pairs, past the image the border is replicated
+template<typename T>
+class FftLoadKernel {
+private:
+    Image<T>* m_input;
+    FftPlan* m_plan;
+    float* m_data;
+    size_t m_first;
+
+public:
+    FftLoadKernel(Image<T>* input, FftPlan* plan, float* data, size_t first)
+        : m_input(input)
+        , m_plan(plan)
+        , m_data(data)
+        , m_first(first)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        size_t pair = m_first + i / m_plan->size;
+
+        for (size_t part = 0; part < 2; ++part) {
+            size_t tile = 2 * pair + part;
+            if (tile >= m_plan->tiles) {
+                m_data[2 * i + part] = 0.0f;
+                continue;
+            }
+
+            size_t tile_rest = tile;
+            size_t voxel_rest = i % m_plan->size;
+            size_t index = 0;
+            for (int d = 1; d <= m_plan->dimensions; ++d) {
+                int origin = tile_rest % m_plan->grid[d] * m_plan->valid[d];
+                int coord = origin - m_plan->anchor[d] + voxel_rest % m_plan->shape[d];
+                tile_rest /= m_plan->grid[d];
+                voxel_rest /= m_plan->shape[d];
+                index += m_input->offset[d] * sycl::clamp(coord, 0, m_input->shape[d] - 1);
+            }
+
+            m_data[2 * i + part] = m_input->data[index];
+        }
+    }
+};
+
+// One work-item per line of a chunk of tile pairs along the axis
+class FftKernel {
+private:
+    FftPlan* m_plan;
+    float* m_data;
+    float* m_scratch;
+    int m_axis;
+    bool m_inverse;
+
 public:
-    using Kernel::Kernel;
+    FftKernel(FftPlan* plan, float* data, float* scratch, int axis, bool inverse)
+        : m_plan(plan)
+        , m_data(data)
+        , m_scratch(scratch)
+        , m_axis(axis)
+        , m_inverse(inverse)
+    {
+    }
 
     void operator()(sycl::id<> i) const
     {
-        m_output->data[i] = 255 - m_input->data[i];
+        size_t stride = m_plan->offset[m_axis];
+        int length = m_plan->shape[m_axis];
+        size_t lines = m_plan->size / length;
+        size_t line = i % lines;
+        size_t base = i / lines * m_plan->size + line / stride * stride * length + line % stride;
+
+        auto radices = m_plan->radices + m_plan->radix_offset[m_axis];
+        auto radix_count = m_plan->radix_offset[m_axis + 1] - m_plan->radix_offset[m_axis];
+        auto twiddles = m_plan->twiddles + 2 * m_plan->twiddle_offset[m_axis];
+        fft_line(m_data + 2 * base, m_scratch + 2 * base, stride, length, radices, radix_count, twiddles, m_inverse);
     }
 };
 
-class ThresholdKernel : public Kernel {
+class FftMultiplyKernel {
 private:
-    uint8_t m_threshold;
-    uint8_t m_max_value;
+    FftPlan* m_plan;
+    float* m_data;
 
 public:
-    ThresholdKernel(Image* input, Image* output, uint8_t threshold, uint8_t max_value)
-        : Kernel(input, output)
-        , m_threshold(threshold)
-        , m_max_value(max_value)
+    FftMultiplyKernel(FftPlan* plan, float* data)
+        : m_plan(plan)
+        , m_data(data)
     {
     }
 
     void operator()(sycl::id<> i) const
     {
-        m_output->data[i] = m_input->data[i] > m_threshold ? m_max_value : 0;
+        size_t frequency = i % m_plan->size;
+        float real = m_data[2 * i];
+        float imag = m_data[2 * i + 1];
+        float spectrum_real = m_plan->spectrum[2 * frequency];
+        float spectrum_imag = m_plan->spectrum[2 * frequency + 1];
+        m_data[2 * i] = real * spectrum_real - imag * spectrum_imag;
+        m_data[2 * i + 1] = real * spectrum_imag + imag * spectrum_real;
+    }
+};
+
+// Writes the part of every tile that the overlap left free of wrapped-around values
+template<typename T>
+class FftStoreKernel {
+private:
+    float* m_data;
+    FftPlan* m_plan;
+    Image<T>* m_output;
+    size_t m_first;
+
+public:
+    FftStoreKernel(float* data, FftPlan* plan, Image<T>* output, size_t first)
+        : m_data(data)
+        , m_plan(plan)
+        , m_output(output)
+        , m_first(first)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        size_t pair = m_first + i / m_plan->size;
+
+        for (size_t part = 0; part < 2; ++part) {
+            size_t tile = 2 * pair + part;
+            if (tile >= m_plan->tiles)
+                continue;
+
+            size_t tile_rest = tile;
+            size_t voxel_rest = i % m_plan->size;
+            size_t index = 0;
+            bool inside = true;
+            for (int d = 1; d <= m_plan->dimensions; ++d) {
+                int voxel = voxel_rest % m_plan->shape[d];
+                int coord = tile_rest % m_plan->grid[d] * m_plan->valid[d] + voxel;
+                tile_rest /= m_plan->grid[d];
+                voxel_rest /= m_plan->shape[d];
+                inside = inside && voxel < m_plan->valid[d] && coord < m_output->shape[d];
+                index += m_output->offset[d] * coord;
+            }
+
+            if (inside)
+                m_output->data[index] = static_cast<T>(m_data[2 * i + part]);
+        }
+    }
+};
+
+template<typename T>
+inline size_t bricked_position(BrickedImage<T>* image, int const* coord)
+{
+    size_t position = 0;
+    for (int d = 1; d <= image->dimensions; ++d)
+        position += image->table[image->table_offset[d] + coord[d]];
+
+    return position;
+}
+
+template<typename T>
+inline void bricked_coord(BrickedImage<T>* image, size_t index, int* coord)
+{
+    int ires = index;
+    for (int d = image->dimensions; d >= 1; --d) {
+        coord[d] = ires / image->offset[d];
+        ires = ires - coord[d] * image->offset[d];
+    }
+}
+
+template<typename T>
+class ToBrickedKernel {
+private:
+    Image<T>* m_input;
+    BrickedImage<T>* m_output;
+
+public:
+    ToBrickedKernel(Image<T>* input, BrickedImage<T>* output)
+        : m_input(input)
+        , m_output(output)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        int coord[VGL_ARR_SHAPE_SIZE];
+        bricked_coord(m_output, i, coord);
+        m_output->data[bricked_position(m_output, coord)] = m_input->data[i];
+    }
+};
+
+template<typename T>
+class FromBrickedKernel {
+private:
+    BrickedImage<T>* m_input;
+    Image<T>* m_output;
+
+public:
+    FromBrickedKernel(BrickedImage<T>* input, Image<T>* output)
+        : m_input(input)
+        , m_output(output)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        int coord[VGL_ARR_SHAPE_SIZE];
+        bricked_coord(m_input, i, coord);
+        m_output->data[i] = m_input->data[bricked_position(m_input, coord)];
     }
 };
 
-class WindowKernel : public Kernel {
+// WindowKernel addressing voxels through the brick tables, launched over the unpadded size
+template<typename T>
+class BrickedWindowKernel {
 protected:
+    BrickedImage<T>* m_input;
+    BrickedImage<T>* m_output;
     Window* m_window;
 
 public:
-    WindowKernel(Image* input, Image* output, Window* window)
-        : Kernel(input, output)
+    BrickedWindowKernel(BrickedImage<T>* input, BrickedImage<T>* output, Window* window)
+        : m_input(input)
+        , m_output(output)
         , m_window(window)
     {
     }
 
     template<typename Func = std::function<void(size_t, size_t)>>
-    inline auto map(size_t index, Func&& apply) const
+    inline size_t map(size_t index, Func&& apply, bool reflect = false) const
     {
         int image_coord[VGL_ARR_SHAPE_SIZE];
         int window_coord[VGL_ARR_SHAPE_SIZE];
+        bricked_coord(m_input, index, image_coord);
+
+        for (size_t window_index = 0; window_index < m_window->size; ++window_index) {
+            if (m_window->data[window_index] == 0)
+                continue;
+
+            int ires = window_index;
+            for (int d = m_window->dimensions; d >= 1; --d) {
+                int off = m_window->offset[d];
+                int idim = ires / off;
+                ires = ires - idim * off;
+                if (reflect)
+                    idim = m_window->shape[d] - 1 - idim;
+                window_coord[d] = sycl::clamp(image_coord[d] + idim - (m_window->shape[d] - 1) / 2, 0, m_input->shape[d] - 1);
+            }
+
+            apply(bricked_position(m_input, window_coord), window_index);
+        }
+
+        return bricked_position(m_output, image_coord);
+    }
+};
+
+template<typename T>
+class BrickedErodeKernel : public BrickedWindowKernel<T> {
+    using BrickedWindowKernel<T>::m_input;
+    using BrickedWindowKernel<T>::m_output;
+    using BrickedWindowKernel<T>::map;
+
+public:
+    using BrickedWindowKernel<T>::BrickedWindowKernel;
+
+    void operator()(sycl::id<> i) const
+    {
+        T pmin = VoxelTraits<T>::max;
+
+        auto position = map(i, [&](auto image_index, auto _) {
+            pmin = sycl::min(pmin, m_input->data[image_index]);
+        });
+
+        m_output->data[position] = pmin;
+    }
+};
+
+template<typename T>
+class BrickedDilateKernel : public BrickedWindowKernel<T> {
+    using BrickedWindowKernel<T>::m_input;
+    using BrickedWindowKernel<T>::m_output;
+    using BrickedWindowKernel<T>::map;
+
+public:
+    using BrickedWindowKernel<T>::BrickedWindowKernel;
+
+    void operator()(sycl::id<> i) const
+    {
+        T pmax = 0;
+
+        auto position = map(i, [&](auto image_index, auto _) {
+            pmax = sycl::max(pmax, m_input->data[image_index]);
+        }, true);
+
+        m_output->data[position] = pmax;
+    }
+};
+
+template<typename T>
+class BrickedConvolveKernel : public BrickedWindowKernel<T> {
+    using BrickedWindowKernel<T>::m_input;
+    using BrickedWindowKernel<T>::m_output;
+    using BrickedWindowKernel<T>::m_window;
+    using BrickedWindowKernel<T>::map;
+
+public:
+    using BrickedWindowKernel<T>::BrickedWindowKernel;
+
+    void operator()(sycl::id<> i) const
+    {
+        float result = 0.0f;
+
+        auto position = map(i, [&](auto image_index, auto window_index) {
+            result += m_input->data[image_index] * m_window->data[window_index];
+        });
+
+        m_output->data[position] = static_cast<T>(result);
+    }
+};
+
+class BinaryKernel {
+protected:
+    BinaryImage* m_input;
+    BinaryImage* m_output;
+
+public:
+    BinaryKernel(BinaryImage* input, BinaryImage* output)
+        : m_input(input)
+        , m_output(output)
+    {
+    }
+
+    inline size_t row_words() const
+    {
+        return m_input->dimensions > 1 ? m_input->offset[2] : m_input->size;
+    }
+
+    inline uint64_t valid_mask(size_t word) const
+    {
+        int tail = m_input->shape[1] % BINARY_WORD_BITS;
+        return word + 1 == row_words() && tail != 0 ? (uint64_t(1) << tail) - 1 : ~uint64_t(0);
+    }
+};
+
+template<typename T>
+class PackKernel {
+private:
+    Image<T>* m_input;
+    BinaryImage* m_output;
+    T m_threshold;
+
+public:
+    PackKernel(Image<T>* input, BinaryImage* output, T threshold)
+        : m_input(input)
+        , m_output(output)
+        , m_threshold(threshold)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        auto row_words = m_output->dimensions > 1 ? m_output->offset[2] : m_output->size;
+
+        size_t image_index = 0;
+        for (int d = m_output->dimensions; d >= 2; --d)
+            image_index += m_input->offset[d] * ((i / m_output->offset[d]) % m_output->shape[d]);
+
+        int x0 = (i % row_words) * BINARY_WORD_BITS;
+        int bits = sycl::min(BINARY_WORD_BITS, m_output->shape[1] - x0);
+
+        uint64_t word = 0;
+        for (int b = 0; b < bits; ++b)
+            if (m_input->data[image_index + (x0 + b) * m_input->offset[1]] > m_threshold)
+                word |= uint64_t(1) << b;
+
+        m_output->data[i] = word;
+    }
+};
+
+template<typename T>
+class UnpackKernel {
+private:
+    BinaryImage* m_input;
+    Image<T>* m_output;
+    T m_max_value;
+
+public:
+    UnpackKernel(BinaryImage* input, Image<T>* output, T max_value)
+        : m_input(input)
+        , m_output(output)
+        , m_max_value(max_value)
+    {
+    }
+
+    void operator()(sycl::id<> i) const
+    {
+        size_t ires = i;
+        size_t word_index = 0;
+        int x = 0;
+
+        for (int d = m_output->dimensions; d >= 1; --d) {
+            int off = m_output->offset[d];
+            int idim = ires / off;
+            ires = ires - idim * off;
+            if (d == 1)
+                x = idim;
+            else
+                word_index += m_input->offset[d] * idim;
+        }
+        word_index += x / BINARY_WORD_BITS;
+
+        m_output->data[i] = (m_input->data[word_index] >> (x % BINARY_WORD_BITS)) & 1 ? m_max_value : 0;
+    }
+};
+
+class BinaryWindowKernel : public BinaryKernel {
+protected:
+    Window* m_window;
+
+public:
+    BinaryWindowKernel(BinaryImage* input, BinaryImage* output, Window* window)
+        : BinaryKernel(input, output)
+        , m_window(window)
+    {
+    }
+
+    // Word whose bit b holds voxel (word * 64 + b + dx) of the row, clamped to the row borders, requires |dx| < 64
+    inline uint64_t shifted(size_t row_index, int word, int dx) const
+    {
+        int words = row_words();
+        int width = m_input->shape[1];
+        uint64_t value = m_input->data[row_index + word];
+
+        if (dx > 0) {
+            uint64_t next = word + 1 < words ? m_input->data[row_index + word + 1] : 0;
+            value = (value >> dx) | (next << (BINARY_WORD_BITS - dx));
+
+            int limit = width - 1 - dx - word * BINARY_WORD_BITS;
+            if (limit < BINARY_WORD_BITS - 1) {
+                int last = width - 1;
+                uint64_t edge = (m_input->data[row_index + last / BINARY_WORD_BITS] >> (last % BINARY_WORD_BITS)) & 1;
+                uint64_t mask = limit < 0 ? ~uint64_t(0) : ~uint64_t(0) << (limit + 1);
+                value = (value & ~mask) | (edge ? mask : 0);
+            }
+        } else if (dx < 0) {
+            uint64_t prev = word > 0 ? m_input->data[row_index + word - 1] : 0;
+            value = (value << -dx) | (prev >> (BINARY_WORD_BITS + dx));
+
+            int limit = -dx - word * BINARY_WORD_BITS;
+            if (limit > 0) {
+                uint64_t edge = m_input->data[row_index] & 1;
+                uint64_t mask = (uint64_t(1) << limit) - 1;
+                value = (value & ~mask) | (edge ? mask : 0);
+            }
+        }
+
+        return value;
+    }
+
+    template<typename Func = std::function<void(uint64_t)>>
+    inline auto map(size_t index, bool reflect, Func&& apply) const
+    {
+        int word_coord[VGL_ARR_SHAPE_SIZE];
         int ires = index;
         int idim = 0;
 
@@ -75,81 +1350,104 @@ public:
             int off = m_input->offset[d];
             idim = ires / off;
             ires = ires - idim * off;
-            image_coord[d] = idim - (m_window->shape[d] - 1) / 2;
+            word_coord[d] = idim;
         }
 
-        size_t image_index = 0;
+        size_t row_index = 0;
         for (size_t window_index = 0; window_index < m_window->size; ++window_index) {
             if (m_window->data[window_index] == 0)
                 continue;
 
             ires = window_index;
-            image_index = 0;
+            row_index = 0;
+            int dx = 0;
 
             for (int d = m_input->dimensions; d > m_window->dimensions; --d)
-                image_index += m_input->offset[d] * image_coord[d];
+                row_index += m_input->offset[d] * word_coord[d];
 
             for (int d = m_window->dimensions; d >= 1; --d) {
                 int off = m_window->offset[d];
                 idim = ires / off;
                 ires = ires - idim * off;
-                window_coord[d] = idim + image_coord[d];
-                window_coord[d] = sycl::clamp(window_coord[d], 0, m_input->shape[d] - 1);
 
-                image_index += m_input->offset[d] * window_coord[d];
+                int delta = idim - (m_window->shape[d] - 1) / 2;
+                if (reflect)
+                    delta = -delta;
+
+                if (d == 1)
+                    dx = delta;
+                else
+                    row_index += m_input->offset[d] * sycl::clamp(word_coord[d] + delta, 0, m_input->shape[d] - 1);
             }
 
-            apply(image_index, window_index);
+            apply(shifted(row_index, word_coord[1], dx));
         }
     }
 };
 
-class ErodeKernel : public WindowKernel {
+class BinaryErodeKernel : public BinaryWindowKernel {
 public:
-    using WindowKernel::WindowKernel;
+    using BinaryWindowKernel::BinaryWindowKernel;
 
     void operator()(sycl::id<> i) const
     {
-        uint8_t pmin = 255;
+        uint64_t result = ~uint64_t(0);
 
-        map(i, [&](auto image_index, auto _) {
-            pmin = sycl::min(pmin, m_input->data[image_index]);
+        map(i, false, [&](auto word) {
+            result &= word;
         });
 
-        m_output->data[i] = pmin;
+        m_output->data[i] = result & valid_mask(i % row_words());
     }
 };
 
-class ConvolveKernel : public WindowKernel {
+class BinaryDilateKernel : public BinaryWindowKernel {
 public:
-    using WindowKernel::WindowKernel;
+    using BinaryWindowKernel::BinaryWindowKernel;
 
     void operator()(sycl::id<> i) const
     {
-        float result = 0.0f;
+        uint64_t result = 0;
 
-        map(i, [&](auto image_index, auto window_index) {
-            result += m_input->data[image_index] * m_window->data[window_index];
+        map(i, true, [&](auto word) {
+            result |= word;
         });
 
-        m_output->data[i] = result;
+        m_output->data[i] = result & valid_mask(i % row_words());
     }
 };
 
-DeviceImage* image_similar_device_from_host(Image* image, sycl::queue& q)
+// Device allocations go through these so that benchmarks can report the device footprint
+template<typename T>
+T* device_malloc(size_t count, sycl::queue& q)
+{
+    auto pointer = sycl::malloc_device<T>(count, q);
+    memory_track_device_allocation(pointer, count * sizeof(T));
+    return pointer;
+}
+
+template<typename T>
+void device_free(T* pointer, sycl::queue& q)
+{
+    memory_track_device_free(pointer);
+    sycl::free(pointer, q);
+}
+
+template<typename T>
+DeviceImage<T>* image_similar_device_from_host(Image<T>* image, sycl::queue& q)
 {
-    auto d_image = new DeviceImage();
-    auto tmp_image = Image();
-    d_image->self = sycl::malloc_device<Image>(1, q);
+    auto d_image = new DeviceImage<T>();
+    auto tmp_image = Image<T>();
+    d_image->self = device_malloc<Image<T>>(1, q);
 
-    d_image->data = sycl::malloc_device<uint8_t>(image->size, q);
+    d_image->data = device_malloc<T>(image->size, q);
     tmp_image.data = d_image->data;
 
-    d_image->shape = sycl::malloc_device<int>(image->dimensions + 1, q);
+    d_image->shape = device_malloc<int>(image->dimensions + 1, q);
     q.copy(image->shape, d_image->shape, image->dimensions + 1).wait();
     tmp_image.shape = d_image->shape;
 
-    d_image->offset = sycl::malloc_device<int>(image->dimensions + 1, q);
+    d_image->offset = device_malloc<int>(image->dimensions + 1, q);
     q.copy(image->offset, d_image->offset, image->dimensions + 1).wait();
     tmp_image.offset = d_image->offset;
 
@@ -160,50 +1458,185 @@ DeviceImage* image_similar_device_from_host(Image* image, sycl::queue& q)
 
     q.copy(&tmp_image, d_image->self, 1).wait();
 
+    // Placed on NUMA nodes by a kernel launch partitioned like the later ones, not by the upload copy
+    if (q.get_device().is_cpu())
+        q.parallel_for(image->size, FillKernel<T>(d_image->self, T())).wait();
+
+    return d_image;
+}
+
+template<typename T>
+DeviceImage<T>* image_device_from_host(Image<T>* image, sycl::queue& q)
+{
+    auto d_image = image_similar_device_from_host(image, q);
+
+    q.copy(image->data, d_image->data, image->size).wait();
+
+    return d_image;
+}
+
+template<typename T>
+DeviceImage<T>* image_device_convert_from_host(Image<T>* image, sycl::queue& q)
+{
+    auto d_image = image_device_from_host(image, q);
+
+    image_destroy(image);
+
     return d_image;
 }
 
-DeviceImage* image_device_from_host(Image* image, sycl::queue& q)
+template<typename T>
+void image_destroy_device(DeviceImage<T>* d_image, sycl::queue& q)
+{
+    device_free(d_image->data, q);
+    device_free(d_image->shape, q);
+    device_free(d_image->offset, q);
+    device_free(d_image->self, q);
+    delete d_image;
+}
+
+// Volume of d_batch sharing its data, shape and offset, only self is owned
+template<typename T>
+DeviceImage<T>* image_volume_device_from_batch(Image<T>* batch, DeviceImage<T>* d_batch, int index, uint8_t batch_dimension, sycl::queue& q)
+{
+    auto d_volume = new DeviceImage<T>();
+    auto tmp_volume = Image<T>();
+    d_volume->self = device_malloc<Image<T>>(1, q);
+
+    d_volume->dimensions = batch->dimensions - batch_dimension;
+    tmp_volume.dimensions = d_volume->dimensions;
+    d_volume->size = batch->offset[d_volume->dimensions + 1];
+    tmp_volume.size = d_volume->size;
+
+    d_volume->data = d_batch->data + index * d_volume->size;
+    tmp_volume.data = d_volume->data;
+    d_volume->shape = d_batch->shape;
+    tmp_volume.shape = d_volume->shape;
+    d_volume->offset = d_batch->offset;
+    tmp_volume.offset = d_volume->offset;
+
+    q.copy(&tmp_volume, d_volume->self, 1).wait();
+
+    return d_volume;
+}
+
+template<typename T>
+void image_volume_destroy_device(DeviceImage<T>* d_volume, sycl::queue& q)
+{
+    device_free(d_volume->self, q);
+    delete d_volume;
+}
+
+DeviceBinaryImage* binary_image_similar_device_from_host(BinaryImage* binary, sycl::queue& q)
+{
+    auto d_binary = new DeviceBinaryImage();
+    auto tmp_binary = BinaryImage();
+    d_binary->self = device_malloc<BinaryImage>(1, q);
+
+    d_binary->data = device_malloc<uint64_t>(binary->size, q);
+    tmp_binary.data = d_binary->data;
+
+    d_binary->shape = device_malloc<int>(binary->dimensions + 1, q);
+    q.copy(binary->shape, d_binary->shape, binary->dimensions + 1).wait();
+    tmp_binary.shape = d_binary->shape;
+
+    d_binary->offset = device_malloc<int>(binary->dimensions + 1, q);
+    q.copy(binary->offset, d_binary->offset, binary->dimensions + 1).wait();
+    tmp_binary.offset = d_binary->offset;
+
+    d_binary->dimensions = binary->dimensions;
+    tmp_binary.dimensions = d_binary->dimensions;
+    d_binary->size = binary->size;
+    tmp_binary.size = d_binary->size;
+
+    q.copy(&tmp_binary, d_binary->self, 1).wait();
+
+    return d_binary;
+}
+
+DeviceBinaryImage* binary_image_device_from_host(BinaryImage* binary, sycl::queue& q)
+{
+    auto d_binary = binary_image_similar_device_from_host(binary, q);
+
+    q.copy(binary->data, d_binary->data, binary->size).wait();
+
+    return d_binary;
+}
+
+void binary_image_destroy_device(DeviceBinaryImage* d_binary, sycl::queue& q)
+{
+    device_free(d_binary->data, q);
+    device_free(d_binary->shape, q);
+    device_free(d_binary->offset, q);
+    device_free(d_binary->self, q);
+    delete d_binary;
+}
+
+template<typename T>
+DeviceBrickedImage<T>* bricked_image_similar_device_from_host(BrickedImage<T>* bricked, sycl::queue& q)
 {
-    auto d_image = image_similar_device_from_host(image, q);
+    auto d_bricked = new DeviceBrickedImage<T>();
+    auto tmp_bricked = BrickedImage<T>();
+    d_bricked->self = device_malloc<BrickedImage<T>>(1, q);
 
-    q.copy(image->data, d_image->data, image->size).wait();
+    d_bricked->data = device_malloc<T>(bricked->capacity, q);
+    tmp_bricked.data = d_bricked->data;
 
-    return d_image;
-}
+    d_bricked->shape = device_malloc<int>(bricked->dimensions + 1, q);
+    q.copy(bricked->shape, d_bricked->shape, bricked->dimensions + 1).wait();
+    tmp_bricked.shape = d_bricked->shape;
 
-DeviceImage* image_device_convert_from_host(Image* image, sycl::queue& q)
-{
-    auto d_image = image_device_from_host(image, q);
+    d_bricked->offset = device_malloc<int>(bricked->dimensions + 1, q);
+    q.copy(bricked->offset, d_bricked->offset, bricked->dimensions + 1).wait();
+    tmp_bricked.offset = d_bricked->offset;
 
-    image_destroy(image);
+    auto table_size = bricked->table_offset[bricked->dimensions] + bricked->shape[bricked->dimensions];
+    d_bricked->table = device_malloc<size_t>(table_size, q);
+    q.copy(bricked->table, d_bricked->table, table_size).wait();
+    tmp_bricked.table = d_bricked->table;
 
-    return d_image;
+    d_bricked->table_offset = device_malloc<int>(bricked->dimensions + 1, q);
+    q.copy(bricked->table_offset, d_bricked->table_offset, bricked->dimensions + 1).wait();
+    tmp_bricked.table_offset = d_bricked->table_offset;
+
+    d_bricked->dimensions = bricked->dimensions;
+    tmp_bricked.dimensions = d_bricked->dimensions;
+    d_bricked->size = bricked->size;
+    tmp_bricked.size = d_bricked->size;
+    d_bricked->capacity = bricked->capacity;
+    tmp_bricked.capacity = d_bricked->capacity;
+
+    q.copy(&tmp_bricked, d_bricked->self, 1).wait();
+
+    return d_bricked;
 }
 
-void image_destroy_device(DeviceImage* d_image, sycl::queue& q)
+template<typename T>
+void bricked_image_destroy_device(DeviceBrickedImage<T>* d_bricked, sycl::queue& q)
 {
-    sycl::free(d_image->data, q);
-    sycl::free(d_image->shape, q);
-    sycl::free(d_image->offset, q);
-    sycl::free(d_image->self, q);
-    delete d_image;
+    device_free(d_bricked->data, q);
+    device_free(d_bricked->shape, q);
+    device_free(d_bricked->offset, q);
+    device_free(d_bricked->table, q);
+    device_free(d_bricked->table_offset, q);
+    device_free(d_bricked->self, q);
+    delete d_bricked;
 }
 
 DeviceWindow* window_similar_device_from_host(Window* window, sycl::queue& q)
 {
     auto d_window = new DeviceWindow();
     auto tmp_window = Window();
-    d_window->self = sycl::malloc_device<Window>(1, q);
+    d_window->self = device_malloc<Window>(1, q);
 
-    d_window->data = sycl::malloc_device<float>(window->size, q);
+    d_window->data = device_malloc<float>(window->size, q);
     tmp_window.data = d_window->data;
 
-    d_window->shape = sycl::malloc_device<int>(window->dimensions + 1, q);
+    d_window->shape = device_malloc<int>(window->dimensions + 1, q);
     q.copy(window->shape, d_window->shape, window->dimensions + 1).wait();
     tmp_window.shape = d_window->shape;
 
-    d_window->offset = sycl::malloc_device<int>(window->dimensions + 1, q);
+    d_window->offset = device_malloc<int>(window->dimensions + 1, q);
     q.copy(window->offset, d_window->offset, window->dimensions + 1).wait();
     tmp_window.offset = d_window->offset;
 
@@ -237,146 +1670,1007 @@ DeviceWindow* window_device_convert_from_host(Window* window, sycl::queue& q)
 
 void window_destroy_device(DeviceWindow* d_window, sycl::queue& q)
 {
-    sycl::free(d_window->data, q);
-    sycl::free(d_window->shape, q);
-    sycl::free(d_window->offset, q);
-    sycl::free(d_window->self, q);
+    device_free(d_window->data, q);
+    device_free(d_window->shape, q);
+    device_free(d_window->offset, q);
+    device_free(d_window->self, q);
     delete d_window;
 }
 
-void benchmark(VglImage* vglimage, size_t rounds, std::function<void(VglImage*, std::string)> save_image)
+DeviceFftPlan* fft_plan_device_from_host(FftPlan* plan, sycl::queue& q)
 {
-    sycl::queue q;
+    auto d_plan = new DeviceFftPlan();
+    auto tmp_plan = FftPlan();
+    d_plan->self = device_malloc<FftPlan>(1, q);
+
+    auto upload = [&]<typename U>(U* data, size_t count) {
+        auto d_data = device_malloc<U>(count, q);
+        q.copy(data, d_data, count).wait();
+        return d_data;
+    };
+
+    auto dimensions = plan->dimensions;
+    auto radix_count = plan->radix_offset[dimensions + 1];
+    auto twiddle_count = plan->twiddle_offset[dimensions + 1];
+    d_plan->shape = tmp_plan.shape = upload(plan->shape, dimensions + 1);
+    d_plan->offset = tmp_plan.offset = upload(plan->offset, dimensions + 1);
+    d_plan->valid = tmp_plan.valid = upload(plan->valid, dimensions + 1);
+    d_plan->grid = tmp_plan.grid = upload(plan->grid, dimensions + 1);
+    d_plan->anchor = tmp_plan.anchor = upload(plan->anchor, dimensions + 1);
+    d_plan->radices = tmp_plan.radices = upload(plan->radices, radix_count);
+    d_plan->radix_offset = tmp_plan.radix_offset = upload(plan->radix_offset, dimensions + 2);
+    d_plan->twiddles = tmp_plan.twiddles = upload(plan->twiddles, 2 * twiddle_count);
+    d_plan->twiddle_offset = tmp_plan.twiddle_offset = upload(plan->twiddle_offset, dimensions + 2);
+    d_plan->spectrum = tmp_plan.spectrum = upload(plan->spectrum, 2 * plan->size);
+
+    d_plan->dimensions = tmp_plan.dimensions = plan->dimensions;
+    d_plan->size = tmp_plan.size = plan->size;
+    d_plan->tiles = tmp_plan.tiles = plan->tiles;
+    d_plan->pairs = tmp_plan.pairs = plan->pairs;
+    d_plan->batch = tmp_plan.batch = plan->batch;
+
+    q.copy(&tmp_plan, d_plan->self, 1).wait();
+
+    return d_plan;
+}
 
-    auto image = image_from_vglimage(vglimage);
+void fft_plan_destroy_device(DeviceFftPlan* d_plan, sycl::queue& q)
+{
+    device_free(d_plan->shape, q);
+    device_free(d_plan->offset, q);
+    device_free(d_plan->valid, q);
+    device_free(d_plan->grid, q);
+    device_free(d_plan->anchor, q);
+    device_free(d_plan->radices, q);
+    device_free(d_plan->radix_offset, q);
+    device_free(d_plan->twiddles, q);
+    device_free(d_plan->twiddle_offset, q);
+    device_free(d_plan->spectrum, q);
+    device_free(d_plan->self, q);
+    delete d_plan;
+}
+
+template<typename T>
+BenchmarkSession benchmark_voxel(Image<uint8_t>* source, VglImage* vglimage, size_t rounds, std::function<void(VglImage*, std::string)> save_image, sycl::queue& q, bool header)
+{
+    auto image = image_cast<T>(source);
+    auto sample = image_similar_from_image(image);
     auto dimensions = image->dimensions;
 
+    auto const suffix = std::is_same_v<T, uint8_t> ? std::string() : std::string("-") + VoxelTraits<T>::name;
+    auto const threshold = voxel_from_uint8<T>(128);
+    auto const max_value = VoxelTraits<T>::max;
+
     auto d_input = image_device_from_host(image, q);
     auto d_output = image_similar_device_from_host(image, q);
     auto d_temp = image_similar_device_from_host(image, q);
-
-    auto d_cross_window = window_device_convert_from_host(window_create_from_type(WindowType::CROSS, dimensions), q);
-    auto d_cube_window = window_device_convert_from_host(window_create_from_type(WindowType::CUBE, dimensions), q);
+    auto d_extra = image_similar_device_from_host(image, q);
+
+    auto cross_window = window_create_from_type(WindowType::CROSS, dimensions);
+    auto cube_window = window_create_from_type(WindowType::CUBE, dimensions);
+    auto const cross_count = window_count(cross_window);
+    auto const cube_count = window_count(cube_window);
+    auto const cube_symmetric = window_symmetric(cube_window);
+    auto d_cross_leading_window = window_device_convert_from_host(window_create_edge_from_window(cross_window, 1, 1), q);
+    auto d_cross_trailing_window = window_device_convert_from_host(window_create_edge_from_window(cross_window, 1, -1), q);
+    auto d_cube_leading_window = window_device_convert_from_host(window_create_edge_from_window(cube_window, 1, 1), q);
+    auto d_cube_trailing_window = window_device_convert_from_host(window_create_edge_from_window(cube_window, 1, -1), q);
+    auto d_cross_window = window_device_convert_from_host(cross_window, q);
+    auto d_cube_window = window_device_convert_from_host(cube_window, q);
     auto d_mean_window = window_device_convert_from_host(window_create_from_type(WindowType::MEAN, dimensions), q);
 
     auto d_cube_window_array = new DeviceWindow*[dimensions + 1];
     auto d_mean_window_array = new DeviceWindow*[dimensions + 1];
-    {
-        auto cube_window_1d = window_create_from_type(WindowType::CUBE, 1);
-        auto mean_window_1d = window_create_from_type(WindowType::MEAN, 1);
+    for (int i = 1; i <= dimensions; ++i) {
+        d_cube_window_array[i] = window_device_convert_from_host(window_create_axis_from_type(WindowType::CUBE, dimensions, i), q);
+        d_mean_window_array[i] = window_device_convert_from_host(window_create_axis_from_type(WindowType::MEAN, dimensions, i), q);
+    }
+
+    auto binary = binary_image_from_image(image, threshold);
+    auto d_binary_input = binary_image_device_from_host(binary, q);
+    auto d_binary_output = binary_image_similar_device_from_host(binary, q);
+    auto d_binary_temp = binary_image_similar_device_from_host(binary, q);
+
+    auto const histogram_groups = std::min<size_t>((image->size + HISTOGRAM_BINS - 1) / HISTOGRAM_BINS, 1024);
+    auto d_partial_histogram = device_malloc<uint32_t>(histogram_groups * HISTOGRAM_BINS, q);
+    auto d_histogram = device_malloc<uint32_t>(HISTOGRAM_BINS, q);
+    auto d_level = device_malloc<T>(1, q);
+    auto d_statistics = device_malloc<Statistics<T>>(1, q);
+
+    auto labels = label_image_similar_from_image(image);
+    auto d_labels = image_similar_device_from_host(labels, q);
+    auto d_mask = image_similar_device_from_host(image, q);
+    q.parallel_for(image->size, ThresholdKernel<T>(d_input->self, d_mask->self, threshold, max_value)).wait();
+
+    auto distances = image_cast<float>(image);
+    auto d_distances = image_similar_device_from_host(distances, q);
+    auto d_distances_temp = image_similar_device_from_host(distances, q);
+    auto d_distance_vertex = device_malloc<int>(image->size, q);
+    auto d_distance_boundary = device_malloc<float>(image->size, q);
+
+    auto d_blur = image_similar_device_from_host(distances, q);
+    auto d_blur_temp = image_similar_device_from_host(distances, q);
+
+    auto const gaussian_sigmas = std::vector<int> { 1, 2, 5, 10, 20 };
+    auto d_gaussian_window_array = std::vector<DeviceWindow*>(gaussian_sigmas.size() * (dimensions + 1));
+    for (size_t s = 0; s < gaussian_sigmas.size(); ++s)
+        for (int i = 1; i <= dimensions; ++i)
+            d_gaussian_window_array[s * (dimensions + 1) + i] = window_device_convert_from_host(window_create_gaussian_axis(gaussian_sigmas[s], dimensions, i), q);
+
+    auto gaussian = [&](GaussianCoefficients coefficients) {
+        q.parallel_for(image->size / image->shape[1], GaussianKernel<T>(d_input->self, d_blur->self, coefficients, 1)).wait();
+        for (int i = 2; i <= dimensions; ++i)
+            if (i & 0b1)
+                q.parallel_for(image->size / image->shape[i], GaussianKernel<float>(d_blur_temp->self, d_blur->self, coefficients, i)).wait();
+            else
+                q.parallel_for(image->size / image->shape[i], GaussianKernel<float>(d_blur->self, d_blur_temp->self, coefficients, i)).wait();
+        auto d_result = dimensions & 0b1 ? d_blur : d_blur_temp;
+        q.parallel_for(image->size, RoundKernel<T>(d_result->self, d_output->self)).wait();
+    };
+
+    auto select_filter = [&](DeviceWindow* d_window, size_t count, int rank) {
+        if (count <= RANK_WINDOW_SIZES[0])
+            q.parallel_for(image->size, RankKernel<T, RANK_WINDOW_SIZES[0]>(d_input->self, d_output->self, d_window->self, rank)).wait();
+        else if (count <= RANK_WINDOW_SIZES[1])
+            q.parallel_for(image->size, RankKernel<T, RANK_WINDOW_SIZES[1]>(d_input->self, d_output->self, d_window->self, rank)).wait();
+        else
+            q.parallel_for(image->size, RankKernel<T, RANK_WINDOW_SIZES[2]>(d_input->self, d_output->self, d_window->self, rank)).wait();
+    };
+
+    auto rank_filter = [&](DeviceWindow* d_window, DeviceWindow* d_leading, DeviceWindow* d_trailing, size_t count, int rank) {
+        if (count <= RANK_NETWORK_SIZE)
+            q.parallel_for(image->size, RankKernel<T, RANK_NETWORK_SIZE>(d_input->self, d_output->self, d_window->self, rank)).wait();
+        else if constexpr (std::is_same_v<T, uint8_t>)
+            q.parallel_for(image->size / image->shape[1], SlidingRankKernel(d_input->self, d_output->self, d_window->self, d_leading->self, d_trailing->self, rank)).wait();
+        else
+            select_filter(d_window, count, rank);
+    };
+
+    struct Strel {
+        std::string name;
+        StrelPlan* plan;
+        DeviceWindow* d_window;
+        std::vector<DeviceWindow*> d_steps;
+    };
 
-        for (int i = 1; i <= dimensions; ++i) {
-            cube_window_1d->shape[i] = 3;
-            mean_window_1d->shape[i] = 3;
+    auto strels = std::vector<Strel>();
+    auto const strel_types = { std::pair(StrelType::BALL, "ball"), std::pair(StrelType::DIAMOND, "diamond"), std::pair(StrelType::ELLIPSOID, "ellipsoid") };
+    if (dimensions <= 3)
+        for (auto [type, name] : strel_types)
+            for (int radius : { 3, 7, 15 }) {
+                int radii[VGL_ARR_SHAPE_SIZE];
+                for (int d = 1; d <= dimensions; ++d)
+                    radii[d] = radius;
+                if (type == StrelType::ELLIPSOID)
+                    radii[dimensions] = (radius + 1) / 2;
+
+                auto plan = strel_plan_create(type, radii, dimensions);
+                auto d_steps = std::vector<DeviceWindow*>();
+                for (auto step : plan->steps)
+                    d_steps.push_back(window_device_from_host(step, q));
+                strels.push_back({ std::string(name) + "-r" + std::to_string(radius), plan, window_device_from_host(plan->window, q), d_steps });
+            }
+    auto reference = image_similar_from_image(image);
+
+    auto strel_erode = [&](Strel const& strel) {
+        if (strel.d_steps.empty()) {
+            q.parallel_for(image->size, ErodeKernel<T>(d_input->self, d_output->self, strel.d_window->self)).wait();
+            return;
+        }
+
+        auto d_source = d_input;
+        for (size_t s = 0; s < strel.d_steps.size(); ++s) {
+            auto d_target = (strel.d_steps.size() - s) & 0b1 ? d_output : d_temp;
+            q.parallel_for(image->size, ErodeKernel<T>(d_source->self, d_target->self, strel.d_steps[s]->self)).wait();
+            d_source = d_target;
+        }
+    };
+
+    struct Psf {
+        std::string name;
+        FftPlan* plan;
+        DeviceFftPlan* d_plan;
+        DeviceWindow* d_window;
+        bool preferred;
+        bool direct;
+    };
+
+    auto psfs = std::vector<Psf>();
+    size_t fft_capacity = 0;
+    for (int sigma : dimensions <= 3 ? std::vector { 1, 2, 5 } : std::vector { 1, 2 }) {
+        auto window = window_create_gaussian(sigma, dimensions);
+        auto plan = fft_plan_create(image->shape, dimensions, window);
+        auto name = "psf-s" + std::to_string(sigma);
+        auto preferred = fft_plan_preferred(plan, window, image->size);
+        std::cerr << name << suffix << ": " << plan->tiles << " tiles of " << plan->size << " voxels, "
+                  << (preferred ? "transform" : "direct window") << " preferred" << std::endl;
+        auto direct = dimensions <= 3 || sigma == 1;
+        psfs.push_back({ name, plan, fft_plan_device_from_host(plan, q), window_device_convert_from_host(window, q), preferred, direct });
+        fft_capacity = std::max(fft_capacity, plan->batch * plan->size);
+    }
+    auto d_fft_data = device_malloc<float>(2 * fft_capacity, q);
+    auto d_fft_scratch = device_malloc<float>(2 * fft_capacity, q);
+
+    auto fft_convolve = [&](Psf const& psf) {
+        auto plan = psf.plan;
+        for (size_t first = 0; first < plan->pairs; first += plan->batch) {
+            auto size = std::min(plan->batch, plan->pairs - first) * plan->size;
+            q.parallel_for(size, FftLoadKernel<T>(d_input->self, psf.d_plan->self, d_fft_data, first)).wait();
+            for (int i = 1; i <= dimensions; ++i)
+                q.parallel_for(size / plan->shape[i], FftKernel(psf.d_plan->self, d_fft_data, d_fft_scratch, i, false)).wait();
+            q.parallel_for(size, FftMultiplyKernel(psf.d_plan->self, d_fft_data)).wait();
+            for (int i = 1; i <= dimensions; ++i)
+                q.parallel_for(size / plan->shape[i], FftKernel(psf.d_plan->self, d_fft_data, d_fft_scratch, i, true)).wait();
+            q.parallel_for(size, FftStoreKernel<T>(d_fft_data, psf.d_plan->self, d_output->self, first)).wait();
+        }
+    };
+
+    struct Operator {
+        PipelineStep step;
+        std::function<void(DeviceImage<T>*, DeviceImage<T>*)> func;
+    };
+
+    auto chain = std::vector<Operator>();
+    chain.push_back({
+        .step = { 0, 1, true },
+        .func = [&](DeviceImage<T>* source, DeviceImage<T>* target) { q.parallel_for(image->size, ThresholdKernel<T>(source->self, target->self, threshold, max_value)).wait(); },
+    });
+    for (int i = 1; i <= dimensions; ++i)
+        chain.push_back({
+            .step = { int(chain.size()), int(chain.size()) + 1, false },
+            .func = [&, i](DeviceImage<T>* source, DeviceImage<T>* target) { q.parallel_for(image->size, ErodeKernel<T>(source->self, target->self, d_cube_window_array[i]->self)).wait(); },
+        });
+    chain.push_back({
+        .step = { int(chain.size()), int(chain.size()) + 1, true },
+        .func = [&](DeviceImage<T>* source, DeviceImage<T>* target) { q.parallel_for(image->size, InvertKernel<T>(source->self, target->self)).wait(); },
+    });
+    for (int i = 1; i <= dimensions; ++i)
+        chain.push_back({
+            .step = { int(chain.size()), int(chain.size()) + 1, false },
+            .func = [&, i](DeviceImage<T>* source, DeviceImage<T>* target) { q.parallel_for(image->size, ConvolveKernel<T>(source->self, target->self, d_mean_window_array[i]->self)).wait(); },
+        });
+
+    auto pipeline_steps = std::vector<PipelineStep>();
+    for (auto const& op : chain)
+        pipeline_steps.push_back(op.step);
+    auto pipeline = pipeline_plan_create(pipeline_steps);
+    memory_reset_peak();
+    auto pipeline_live = memory_usage().device.live;
+    auto d_pipeline_buffers = std::vector<DeviceImage<T>*> { d_input };
+    for (int b = 1; b < pipeline->count; ++b)
+        d_pipeline_buffers.push_back(image_similar_device_from_host(image, q));
+    auto pipeline_measured = memory_usage().device.peak - pipeline_live + image->size * sizeof(T);
+
+    std::cerr << "threshold-erode-invert-convolve" << suffix << ": " << pipeline->count << " buffers ("
+              << pipeline->count * image->size * sizeof(T) << " bytes) planned, " << pipeline_measured << " bytes measured, "
+              << chain.size() + 1 << " buffers (" << (chain.size() + 1) * image->size * sizeof(T) << " bytes) naive" << std::endl;
+
+    struct Batch {
+        int count;
+        DeviceImage<T>* d_input;
+        DeviceImage<T>* d_output;
+        std::vector<DeviceImage<T>*> d_input_volumes;
+        std::vector<DeviceImage<T>*> d_output_volumes;
+    };
 
-            d_cube_window_array[i] = window_device_from_host(cube_window_1d, q);
-            d_mean_window_array[i] = window_device_from_host(mean_window_1d, q);
+    auto batch_cube_window = window_create_from_type(WindowType::CUBE, dimensions);
+    auto batch_mean_window = window_create_from_type(WindowType::MEAN, dimensions);
+    auto d_batch_cube_window = window_device_convert_from_host(window_batch_from_window(batch_cube_window, 1), q);
+    auto d_batch_mean_window = window_device_convert_from_host(window_batch_from_window(batch_mean_window, 1), q);
+    window_destroy(batch_cube_window);
+    window_destroy(batch_mean_window);
+
+    auto batches = std::vector<Batch>();
+    for (int count = 1; count <= 1024; count *= 4) {
+        auto batch_image = image_batch_from_image(image, batch_volume_edge(dimensions), count);
+        auto batch = Batch { count, image_device_from_host(batch_image, q), image_similar_device_from_host(batch_image, q) };
+        for (int b = 0; b < count; ++b) {
+            batch.d_input_volumes.push_back(image_volume_device_from_batch(batch_image, batch.d_input, b, 1, q));
+            batch.d_output_volumes.push_back(image_volume_device_from_batch(batch_image, batch.d_output, b, 1, q));
+        }
+        batches.push_back(batch);
+        image_destroy(batch_image);
+    }
 
-            cube_window_1d->shape[i] = 1;
-            mean_window_1d->shape[i] = 1;
+    auto d_volume_cube_window = (DeviceWindow*)nullptr;
+    auto d_axes_cube_window = (DeviceWindow*)nullptr;
+    auto d_axes_input_volumes = std::vector<DeviceImage<T>*>();
+    auto d_axes_output_volumes = std::vector<DeviceImage<T>*>();
+    if (dimensions == 5) {
+        auto volume_cube_window = window_create_from_type(WindowType::CUBE, 3);
+        d_axes_cube_window = window_device_convert_from_host(window_batch_from_window(volume_cube_window, 2), q);
+        d_volume_cube_window = window_device_convert_from_host(volume_cube_window, q);
+
+        for (int b = 0; b < image->shape[4] * image->shape[5]; ++b) {
+            d_axes_input_volumes.push_back(image_volume_device_from_batch(image, d_input, b, 2, q));
+            d_axes_output_volumes.push_back(image_volume_device_from_batch(image, d_temp, b, 2, q));
         }
+    }
 
-        window_destroy(cube_window_1d);
-        window_destroy(mean_window_1d);
+    struct Layout {
+        std::string name;
+        BrickedImage<T>* bricked;
+        DeviceBrickedImage<T>* d_input;
+        DeviceBrickedImage<T>* d_output;
+        DeviceBrickedImage<T>* d_temp;
+    };
+
+    auto layouts = std::vector<Layout>();
+    for (auto [order, name] : { std::pair(BrickOrder::ROW_MAJOR, "bricked"), std::pair(BrickOrder::MORTON, "morton") }) {
+        auto bricked = bricked_image_similar_from_image(image, order);
+        std::cerr << name << suffix << ": " << bricked->capacity << " voxels padded from " << image->size << std::endl;
+        auto d_bricked_input = bricked_image_similar_device_from_host(bricked, q);
+        q.parallel_for(image->size, ToBrickedKernel<T>(d_input->self, d_bricked_input->self)).wait();
+        layouts.push_back({ name, bricked, d_bricked_input, bricked_image_similar_device_from_host(bricked, q), bricked_image_similar_device_from_host(bricked, q) });
     }
 
+    auto label = [&](DeviceWindow* d_window) {
+        q.parallel_for(image->size, LabelInitKernel<T>(d_mask->self, d_labels->self)).wait();
+        q.parallel_for(image->size, LabelMergeKernel<T>(d_mask->self, d_labels->self, d_window->self)).wait();
+        q.parallel_for(image->size, LabelFlattenKernel(d_labels->self)).wait();
+    };
+
+    auto histogram = [&] {
+        q.submit([&](sycl::handler& h) {
+             auto local = sycl::local_accessor<uint32_t, 1>(HISTOGRAM_BINS, h);
+             h.parallel_for(sycl::nd_range<1>(histogram_groups * HISTOGRAM_BINS, HISTOGRAM_BINS), HistogramKernel<T>(d_input->self, d_partial_histogram, local));
+         }).wait();
+        q.parallel_for(HISTOGRAM_BINS, HistogramMergeKernel(d_partial_histogram, d_histogram, histogram_groups)).wait();
+    };
+
     auto save_sample = [&](std::string name) {
-        q.memcpy(vglimage->getImageData(), d_output->data, d_output->size);
+        q.copy(d_output->data, sample->data, sample->size).wait();
+        image_to_vglimage(sample, vglimage);
+        save_image(vglimage, name);
+    };
+
+    auto save_distance_sample = [&](std::string name) {
+        q.copy(d_distances->data, distances->data, distances->size).wait();
+        distance_image_to_vglimage(distances, vglimage);
+        save_image(vglimage, name);
+    };
+
+    auto save_label_sample = [&](std::string name) {
+        q.copy(d_labels->data, labels->data, labels->size).wait();
+        label_image_to_vglimage(labels, vglimage);
         save_image(vglimage, name);
     };
 
+    auto save_binary_sample = [&](std::string name) {
+        q.parallel_for(image->size, UnpackKernel<T>(d_binary_output->self, d_output->self, max_value)).wait();
+        save_sample(name);
+    };
+
     auto builder = BenchmarkBuilder();
     builder.attach({
-        .name = "upload",
+        .name = "upload" + suffix,
         .type = "group",
         .group = "memory",
         .func = [&] { q.copy(image->data, d_input->data, image->size).wait(); },
     });
     builder.attach({
-        .name = "download",
+        .name = "download" + suffix,
         .type = "group",
         .group = "memory",
         .func = [&] { q.copy(d_input->data, image->data, image->size).wait(); },
     });
     builder.attach({
-        .name = "copy",
+        .name = "copy" + suffix,
         .type = "group",
         .group = "memory",
         .post = save_sample,
         .func = [&] { q.copy(d_input->data, d_output->data, image->size).wait(); },
     });
     builder.attach({
-        .name = "invert",
+        .name = "invert" + suffix,
         .type = "group",
         .group = "point",
         .post = save_sample,
-        .func = [&] { q.parallel_for(image->size, InvertKernel(d_input->self, d_output->self)).wait(); },
+        .func = [&] { q.parallel_for(image->size, InvertKernel<T>(d_input->self, d_output->self)).wait(); },
     });
     builder.attach({
-        .name = "threshold",
+        .name = "threshold" + suffix,
         .type = "group",
         .group = "point",
         .post = save_sample,
-        .func = [&] { q.parallel_for(image->size, ThresholdKernel(d_input->self, d_output->self, 128, 255)).wait(); },
+        .func = [&] { q.parallel_for(image->size, ThresholdKernel<T>(d_input->self, d_output->self, threshold, max_value)).wait(); },
+    });
+    builder.attach({
+        .name = "histogram" + suffix,
+        .type = "group",
+        .group = "reduction",
+        .func = histogram,
+    });
+    builder.attach({
+        .name = "statistics" + suffix,
+        .type = "group",
+        .group = "reduction",
+        .func = [&] {
+            auto initialize = sycl::property::reduction::initialize_to_identity();
+            q.parallel_for(sycl::range<1>(image->size),
+                 sycl::reduction(&d_statistics->min, sycl::minimum<T>(), initialize),
+                 sycl::reduction(&d_statistics->max, sycl::maximum<T>(), initialize),
+                 sycl::reduction(&d_statistics->sum, sycl::plus<double>(), initialize),
+                 StatisticsKernel<T>(d_input->self))
+                .wait();
+            q.single_task(MeanKernel<T>(d_statistics, image->size)).wait();
+        },
+    });
+    builder.attach({
+        .name = "otsu-threshold" + suffix,
+        .type = "group",
+        .group = "reduction",
+        .post = save_sample,
+        .func = [&] {
+            histogram();
+            q.single_task(OtsuKernel<T>(d_histogram, d_level)).wait();
+            q.parallel_for(image->size, DeviceThresholdKernel<T>(d_input->self, d_output->self, d_level, max_value)).wait();
+        },
     });
     builder.attach({
-        .name = "erode-cross",
+        .name = "erode-cross" + suffix,
         .type = "single",
         .post = save_sample,
-        .func = [&] { q.parallel_for(image->size, ErodeKernel(d_input->self, d_output->self, d_cross_window->self)).wait(); },
+        .func = [&] { q.parallel_for(image->size, ErodeKernel<T>(d_input->self, d_output->self, d_cross_window->self)).wait(); },
     });
     builder.attach({
-        .name = "erode-cube",
+        .name = "erode-cube" + suffix,
         .type = "single",
         .post = save_sample,
-        .func = [&] { q.parallel_for(image->size, ErodeKernel(d_input->self, d_output->self, d_cube_window->self)).wait(); },
+        .func = [&] { q.parallel_for(image->size, ErodeKernel<T>(d_input->self, d_output->self, d_cube_window->self)).wait(); },
     });
     builder.attach({
-        .name = "split-erode-cube",
+        .name = "split-erode-cube" + suffix,
         .type = "single",
         .post = save_sample,
         .func = [&] {
-            q.parallel_for(image->size, ErodeKernel(d_input->self, d_temp->self, d_cube_window_array[1]->self)).wait();
+            q.parallel_for(image->size, ErodeKernel<T>(d_input->self, d_temp->self, d_cube_window_array[1]->self)).wait();
             for (int i = 2; i <= dimensions; ++i)
                 if (i & 0b1)
-                    q.parallel_for(image->size, ErodeKernel(d_output->self, d_temp->self, d_cube_window_array[i]->self)).wait();
+                    q.parallel_for(image->size, ErodeKernel<T>(d_output->self, d_temp->self, d_cube_window_array[i]->self)).wait();
                 else
-                    q.parallel_for(image->size, ErodeKernel(d_temp->self, d_output->self, d_cube_window_array[i]->self)).wait();
+                    q.parallel_for(image->size, ErodeKernel<T>(d_temp->self, d_output->self, d_cube_window_array[i]->self)).wait();
             if (dimensions & 0b1)
-                q.copy(d_output->data, d_temp->data, image->size).wait();
+                q.copy(d_temp->data, d_output->data, image->size).wait();
+        },
+    });
+    builder.attach({
+        .name = "distance-transform" + suffix,
+        .type = "single",
+        .post = save_distance_sample,
+        .func = [&] {
+            q.parallel_for(image->size, DistanceInitKernel<T>(d_mask->self, d_distances->self)).wait();
+            for (int i = 1; i <= dimensions; ++i)
+                if (i & 0b1)
+                    q.parallel_for(image->size / image->shape[i], DistanceKernel(d_distances->self, d_distances_temp->self, d_distance_vertex, d_distance_boundary, i))
+                        .wait();
+                else
+                    q.parallel_for(image->size / image->shape[i], DistanceKernel(d_distances_temp->self, d_distances->self, d_distance_vertex, d_distance_boundary, i))
+                        .wait();
+            auto d_result = dimensions & 0b1 ? d_distances_temp : d_distances;
+            q.parallel_for(image->size, DistanceRootKernel(d_result->self, d_distances->self)).wait();
         },
     });
     builder.attach({
-        .name = "convolve",
+        .name = "convolve" + suffix,
         .type = "single",
         .post = save_sample,
-        .func = [&] { q.parallel_for(image->size, ConvolveKernel(d_input->self, d_output->self, d_mean_window->self)).wait(); },
+        .func = [&] { q.parallel_for(image->size, ConvolveKernel<T>(d_input->self, d_output->self, d_mean_window->self)).wait(); },
     });
     builder.attach({
-        .name = "split-convolve",
+        .name = "split-convolve" + suffix,
         .type = "single",
         .post = save_sample,
         .func = [&] {
-            q.parallel_for(image->size, ConvolveKernel(d_input->self, d_temp->self, d_mean_window_array[1]->self)).wait();
+            q.parallel_for(image->size, ConvolveKernel<T>(d_input->self, d_temp->self, d_mean_window_array[1]->self)).wait();
             for (int i = 2; i <= dimensions; ++i)
                 if (i & 0b1)
-                    q.parallel_for(image->size, ConvolveKernel(d_output->self, d_temp->self, d_mean_window_array[i]->self))
+                    q.parallel_for(image->size, ConvolveKernel<T>(d_output->self, d_temp->self, d_mean_window_array[i]->self))
                         .wait();
                 else
-                    q.parallel_for(image->size, ConvolveKernel(d_temp->self, d_output->self, d_mean_window_array[i]->self))
+                    q.parallel_for(image->size, ConvolveKernel<T>(d_temp->self, d_output->self, d_mean_window_array[i]->self))
                         .wait();
             if (dimensions & 0b1)
-                q.copy(d_output->data, d_temp->data, image->size).wait();
+                q.copy(d_temp->data, d_output->data, image->size).wait();
+        },
+    });
+    for (size_t s = 0; s < gaussian_sigmas.size(); ++s) {
+        auto const sigma = "-sigma" + std::to_string(gaussian_sigmas[s]);
+        auto const coefficients = gaussian_coefficients(gaussian_sigmas[s]);
+        auto const d_window_array = d_gaussian_window_array.data() + s * (dimensions + 1);
+        builder.attach({
+            .name = "gaussian" + sigma + suffix,
+            .type = "single",
+            .post = save_sample,
+            .func = [&, coefficients] { gaussian(coefficients); },
+        });
+        builder.attach({
+            .name = "split-convolve-gaussian" + sigma + suffix,
+            .type = "single",
+            .post = save_sample,
+            .func = [&, d_window_array] {
+                q.parallel_for(image->size, ConvolveKernel<T>(d_input->self, d_temp->self, d_window_array[1]->self)).wait();
+                for (int i = 2; i <= dimensions; ++i)
+                    if (i & 0b1)
+                        q.parallel_for(image->size, ConvolveKernel<T>(d_output->self, d_temp->self, d_window_array[i]->self)).wait();
+                    else
+                        q.parallel_for(image->size, ConvolveKernel<T>(d_temp->self, d_output->self, d_window_array[i]->self)).wait();
+                if (dimensions & 0b1)
+                    q.copy(d_temp->data, d_output->data, image->size).wait();
+            },
+        });
+    }
+    builder.attach({
+        .name = "dilate-cross" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] { q.parallel_for(image->size, DilateKernel<T>(d_input->self, d_output->self, d_cross_window->self)).wait(); },
+    });
+    builder.attach({
+        .name = "dilate-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] { q.parallel_for(image->size, DilateKernel<T>(d_input->self, d_output->self, d_cube_window->self)).wait(); },
+    });
+    builder.attach({
+        .name = "split-dilate-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            q.parallel_for(image->size, DilateKernel<T>(d_input->self, d_temp->self, d_cube_window_array[1]->self)).wait();
+            for (int i = 2; i <= dimensions; ++i)
+                if (i & 0b1)
+                    q.parallel_for(image->size, DilateKernel<T>(d_output->self, d_temp->self, d_cube_window_array[i]->self)).wait();
+                else
+                    q.parallel_for(image->size, DilateKernel<T>(d_temp->self, d_output->self, d_cube_window_array[i]->self)).wait();
+            if (dimensions & 0b1)
+                q.copy(d_temp->data, d_output->data, image->size).wait();
+        },
+    });
+    builder.attach({
+        .name = "open-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            q.parallel_for(image->size, ErodeKernel<T>(d_input->self, d_temp->self, d_cube_window->self)).wait();
+            q.parallel_for(image->size, DilateKernel<T>(d_temp->self, d_output->self, d_cube_window->self)).wait();
+        },
+    });
+    builder.attach({
+        .name = "close-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            q.parallel_for(image->size, DilateKernel<T>(d_input->self, d_temp->self, d_cube_window->self)).wait();
+            q.parallel_for(image->size, ErodeKernel<T>(d_temp->self, d_output->self, d_cube_window->self)).wait();
+        },
+    });
+    builder.attach({
+        .name = "gradient-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] { q.parallel_for(image->size, GradientKernel<T>(d_input->self, d_output->self, d_cube_window->self, cube_symmetric)).wait(); },
+    });
+    builder.attach({
+        .name = "naive-gradient-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            q.parallel_for(image->size, DilateKernel<T>(d_input->self, d_temp->self, d_cube_window->self)).wait();
+            q.parallel_for(image->size, ErodeKernel<T>(d_input->self, d_extra->self, d_cube_window->self)).wait();
+            q.parallel_for(image->size, SubtractKernel<T>(d_temp->self, d_extra->self, d_output->self)).wait();
+        },
+    });
+    builder.attach({
+        .name = "tophat-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            q.parallel_for(image->size, ErodeKernel<T>(d_input->self, d_temp->self, d_cube_window->self)).wait();
+            q.parallel_for(image->size, WhiteTopHatKernel<T>(d_temp->self, d_output->self, d_cube_window->self, d_input->self)).wait();
+        },
+    });
+    builder.attach({
+        .name = "naive-tophat-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            q.parallel_for(image->size, ErodeKernel<T>(d_input->self, d_temp->self, d_cube_window->self)).wait();
+            q.parallel_for(image->size, DilateKernel<T>(d_temp->self, d_extra->self, d_cube_window->self)).wait();
+            q.parallel_for(image->size, SubtractKernel<T>(d_input->self, d_extra->self, d_output->self)).wait();
+        },
+    });
+    builder.attach({
+        .name = "blackhat-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            q.parallel_for(image->size, DilateKernel<T>(d_input->self, d_temp->self, d_cube_window->self)).wait();
+            q.parallel_for(image->size, BlackTopHatKernel<T>(d_temp->self, d_output->self, d_cube_window->self, d_input->self)).wait();
+        },
+    });
+    builder.attach({
+        .name = "naive-blackhat-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            q.parallel_for(image->size, DilateKernel<T>(d_input->self, d_temp->self, d_cube_window->self)).wait();
+            q.parallel_for(image->size, ErodeKernel<T>(d_temp->self, d_extra->self, d_cube_window->self)).wait();
+            q.parallel_for(image->size, SubtractKernel<T>(d_extra->self, d_input->self, d_output->self)).wait();
+        },
+    });
+    builder.attach({
+        .name = "threshold-erode-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            q.parallel_for(image->size, ThresholdKernel<T>(d_input->self, d_temp->self, threshold, max_value)).wait();
+            q.parallel_for(image->size, ErodeKernel<T>(d_temp->self, d_output->self, d_cube_window->self)).wait();
+        },
+    });
+    builder.attach({
+        .name = "threshold-erode-invert-convolve" + suffix,
+        .type = "single",
+        .post = [&](std::string name) {
+            q.copy(d_pipeline_buffers[pipeline->buffers.back()]->data, d_output->data, image->size).wait();
+            save_sample(name);
+        },
+        .func = [&] {
+            for (auto const& op : chain)
+                op.func(d_pipeline_buffers[pipeline->buffers[op.step.input]], d_pipeline_buffers[pipeline->buffers[op.step.output]]);
+        },
+    });
+    builder.attach({
+        .name = "median-cross" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] { rank_filter(d_cross_window, d_cross_leading_window, d_cross_trailing_window, cross_count, cross_count / 2); },
+    });
+    builder.attach({
+        .name = "median-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] { rank_filter(d_cube_window, d_cube_leading_window, d_cube_trailing_window, cube_count, cube_count / 2); },
+    });
+    builder.attach({
+        .name = "naive-median-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] { select_filter(d_cube_window, cube_count, cube_count / 2); },
+    });
+    builder.attach({
+        .name = "percentile90-cube" + suffix,
+        .type = "single",
+        .post = save_sample,
+        .func = [&] { rank_filter(d_cube_window, d_cube_leading_window, d_cube_trailing_window, cube_count, rank_from_percentile(90, cube_count)); },
+    });
+    for (auto const& strel : strels) {
+        builder.attach({
+            .name = "erode-" + strel.name + suffix,
+            .type = "single",
+            .post = [&](std::string name) {
+                save_sample(name);
+                q.parallel_for(image->size, ErodeKernel<T>(d_input->self, d_extra->self, strel.d_window->self)).wait();
+                q.copy(d_extra->data, reference->data, reference->size).wait();
+                auto mismatches = std::inner_product(sample->data, sample->data + sample->size, reference->data, size_t(0), std::plus<>(), std::not_equal_to<>());
+                std::cerr << name << ": " << strel.d_steps.size() << " passes, " << mismatches << " voxels differ from the direct window\n";
+            },
+            .func = [&] { strel_erode(strel); },
+        });
+        builder.attach({
+            .name = "direct-erode-" + strel.name + suffix,
+            .type = "single",
+            .post = save_sample,
+            .func = [&] { q.parallel_for(image->size, ErodeKernel<T>(d_input->self, d_output->self, strel.d_window->self)).wait(); },
+        });
+    }
+    for (auto const& psf : psfs) {
+        if (psf.direct)
+            builder.attach({
+                .name = "convolve-" + psf.name + suffix,
+                .type = "single",
+                .post = save_sample,
+                .func = [&] { q.parallel_for(image->size, ConvolveKernel<T>(d_input->self, d_output->self, psf.d_window->self)).wait(); },
+            });
+        builder.attach({
+            .name = "fft-convolve-" + psf.name + suffix,
+            .type = "single",
+            .post = [&](std::string name) {
+                save_sample(name);
+                if (!psf.direct)
+                    return;
+                auto max = [](float a, float b) { return std::max(a, b); };
+                auto distance = [](T a, T b) { return std::abs(float(a) - float(b)); };
+                q.parallel_for(image->size, ConvolveKernel<T>(d_input->self, d_extra->self, psf.d_window->self)).wait();
+                q.copy(d_extra->data, reference->data, reference->size).wait();
+                auto difference = std::inner_product(sample->data, sample->data + sample->size, reference->data, 0.0f, max, distance);
+                std::cerr << name << ": " << psf.plan->tiles << " tiles, " << difference << " largest difference from the direct window\n";
+            },
+            .func = [&] { fft_convolve(psf); },
+        });
+        builder.attach({
+            .name = "auto-convolve-" + psf.name + suffix,
+            .type = "single",
+            .post = save_sample,
+            .func = [&] {
+                if (psf.preferred)
+                    fft_convolve(psf);
+                else
+                    q.parallel_for(image->size, ConvolveKernel<T>(d_input->self, d_output->self, psf.d_window->self)).wait();
+            },
+        });
+    }
+    for (auto const& batch : batches) {
+        auto const count = "-" + std::to_string(batch.count);
+
+        builder.attach({
+            .name = "batched-erode-cube" + count + suffix,
+            .type = "group",
+            .group = "batch",
+            .func = [&] { q.parallel_for(batch.d_input->size, ErodeKernel<T>(batch.d_input->self, batch.d_output->self, d_batch_cube_window->self)).wait(); },
+        });
+        builder.attach({
+            .name = "looped-erode-cube" + count + suffix,
+            .type = "group",
+            .group = "batch",
+            .func = [&] {
+                for (int b = 0; b < batch.count; ++b)
+                    q.parallel_for(batch.d_input_volumes[b]->size, ErodeKernel<T>(batch.d_input_volumes[b]->self, batch.d_output_volumes[b]->self, d_cube_window->self))
+                        .wait();
+            },
+        });
+        builder.attach({
+            .name = "batched-convolve" + count + suffix,
+            .type = "group",
+            .group = "batch",
+            .func = [&] { q.parallel_for(batch.d_input->size, ConvolveKernel<T>(batch.d_input->self, batch.d_output->self, d_batch_mean_window->self)).wait(); },
+        });
+        builder.attach({
+            .name = "looped-convolve" + count + suffix,
+            .type = "group",
+            .group = "batch",
+            .func = [&] {
+                for (int b = 0; b < batch.count; ++b)
+                    q.parallel_for(batch.d_input_volumes[b]->size, ConvolveKernel<T>(batch.d_input_volumes[b]->self, batch.d_output_volumes[b]->self, d_mean_window->self))
+                        .wait();
+            },
+        });
+    }
+    if (dimensions == 5) {
+        auto axes_looped_erode = [&] {
+            for (size_t b = 0; b < d_axes_input_volumes.size(); ++b)
+                q.parallel_for(d_axes_input_volumes[b]->size, ErodeKernel<T>(d_axes_input_volumes[b]->self, d_axes_output_volumes[b]->self, d_volume_cube_window->self))
+                    .wait();
+        };
+
+        builder.attach({
+            .name = "batched-erode-cube-axes" + suffix,
+            .type = "group",
+            .group = "batch",
+            .post = [&, axes_looped_erode](std::string name) {
+                axes_looped_erode();
+                q.copy(d_output->data, sample->data, sample->size).wait();
+                q.copy(d_temp->data, reference->data, reference->size).wait();
+                auto mismatches = std::inner_product(sample->data, sample->data + sample->size, reference->data, size_t(0), std::plus<>(), std::not_equal_to<>());
+                std::cerr << name << ": " << d_axes_input_volumes.size() << " volumes, " << mismatches << " voxels differ from the looped volumes\n";
+            },
+            .func = [&] { q.parallel_for(image->size, ErodeKernel<T>(d_input->self, d_output->self, d_axes_cube_window->self)).wait(); },
+        });
+        builder.attach({
+            .name = "looped-erode-cube-axes" + suffix,
+            .type = "group",
+            .group = "batch",
+            .func = axes_looped_erode,
+        });
+    }
+    for (auto const& layout : layouts) {
+        auto const prefix = layout.name + "-";
+        auto save_bricked_sample = [&](std::string name) {
+            q.parallel_for(image->size, FromBrickedKernel<T>(layout.d_output->self, d_output->self)).wait();
+            save_sample(name);
+        };
+
+        builder.attach({
+            .name = "to-" + layout.name + suffix,
+            .type = "group",
+            .group = "layout",
+            .func = [&] { q.parallel_for(image->size, ToBrickedKernel<T>(d_input->self, layout.d_output->self)).wait(); },
+        });
+        builder.attach({
+            .name = "from-" + layout.name + suffix,
+            .type = "group",
+            .group = "layout",
+            .func = [&] { q.parallel_for(image->size, FromBrickedKernel<T>(layout.d_input->self, d_output->self)).wait(); },
+        });
+        builder.attach({
+            .name = prefix + "erode-cross" + suffix,
+            .type = "single",
+            .post = save_bricked_sample,
+            .func = [&] { q.parallel_for(image->size, BrickedErodeKernel<T>(layout.d_input->self, layout.d_output->self, d_cross_window->self)).wait(); },
+        });
+        builder.attach({
+            .name = prefix + "erode-cube" + suffix,
+            .type = "single",
+            .post = save_bricked_sample,
+            .func = [&] { q.parallel_for(image->size, BrickedErodeKernel<T>(layout.d_input->self, layout.d_output->self, d_cube_window->self)).wait(); },
+        });
+        builder.attach({
+            .name = prefix + "split-erode-cube" + suffix,
+            .type = "single",
+            .post = save_bricked_sample,
+            .func = [&] {
+                q.parallel_for(image->size, BrickedErodeKernel<T>(layout.d_input->self, layout.d_temp->self, d_cube_window_array[1]->self)).wait();
+                for (int i = 2; i <= dimensions; ++i)
+                    if (i & 0b1)
+                        q.parallel_for(image->size, BrickedErodeKernel<T>(layout.d_output->self, layout.d_temp->self, d_cube_window_array[i]->self)).wait();
+                    else
+                        q.parallel_for(image->size, BrickedErodeKernel<T>(layout.d_temp->self, layout.d_output->self, d_cube_window_array[i]->self)).wait();
+                if (dimensions & 0b1)
+                    q.copy(layout.d_temp->data, layout.d_output->data, layout.bricked->capacity).wait();
+            },
+        });
+        builder.attach({
+            .name = prefix + "dilate-cube" + suffix,
+            .type = "single",
+            .post = save_bricked_sample,
+            .func = [&] { q.parallel_for(image->size, BrickedDilateKernel<T>(layout.d_input->self, layout.d_output->self, d_cube_window->self)).wait(); },
+        });
+        builder.attach({
+            .name = prefix + "convolve" + suffix,
+            .type = "single",
+            .post = save_bricked_sample,
+            .func = [&] { q.parallel_for(image->size, BrickedConvolveKernel<T>(layout.d_input->self, layout.d_output->self, d_mean_window->self)).wait(); },
+        });
+        builder.attach({
+            .name = prefix + "split-convolve" + suffix,
+            .type = "single",
+            .post = save_bricked_sample,
+            .func = [&] {
+                q.parallel_for(image->size, BrickedConvolveKernel<T>(layout.d_input->self, layout.d_temp->self, d_mean_window_array[1]->self)).wait();
+                for (int i = 2; i <= dimensions; ++i)
+                    if (i & 0b1)
+                        q.parallel_for(image->size, BrickedConvolveKernel<T>(layout.d_output->self, layout.d_temp->self, d_mean_window_array[i]->self)).wait();
+                    else
+                        q.parallel_for(image->size, BrickedConvolveKernel<T>(layout.d_temp->self, layout.d_output->self, d_mean_window_array[i]->self)).wait();
+                if (dimensions & 0b1)
+                    q.copy(layout.d_temp->data, layout.d_output->data, layout.bricked->capacity).wait();
+            },
+        });
+    }
+    builder.attach({
+        .name = "label-cross" + suffix,
+        .type = "single",
+        .post = save_label_sample,
+        .func = [&] { label(d_cross_window); },
+    });
+    builder.attach({
+        .name = "label-cube" + suffix,
+        .type = "single",
+        .post = save_label_sample,
+        .func = [&] { label(d_cube_window); },
+    });
+    builder.attach({
+        .name = "binary-erode-cube" + suffix,
+        .type = "single",
+        .post = save_binary_sample,
+        .func = [&] { q.parallel_for(binary->size, BinaryErodeKernel(d_binary_input->self, d_binary_output->self, d_cube_window->self)).wait(); },
+    });
+    builder.attach({
+        .name = "binary-dilate-cube" + suffix,
+        .type = "single",
+        .post = [&](std::string name) {
+            save_binary_sample(name);
+            q.parallel_for(image->size, ThresholdKernel<T>(d_input->self, d_extra->self, threshold, max_value)).wait();
+            q.parallel_for(image->size, DilateKernel<T>(d_extra->self, d_output->self, d_cube_window->self)).wait();
+            q.copy(d_output->data, reference->data, reference->size).wait();
+            auto mismatches = std::inner_product(sample->data, sample->data + sample->size, reference->data, size_t(0), std::plus<>(), std::not_equal_to<>());
+            std::cerr << name << ": " << mismatches << " voxels differ from the thresholded dilation\n";
+        },
+        .func = [&] { q.parallel_for(binary->size, BinaryDilateKernel(d_binary_input->self, d_binary_output->self, d_cube_window->self)).wait(); },
+    });
+    builder.attach({
+        .name = "binary-threshold-erode-cube" + suffix,
+        .type = "single",
+        .post = save_binary_sample,
+        .func = [&] {
+            q.parallel_for(binary->size, PackKernel<T>(d_input->self, d_binary_temp->self, threshold)).wait();
+            q.parallel_for(binary->size, BinaryErodeKernel(d_binary_temp->self, d_binary_output->self, d_cube_window->self)).wait();
         },
     });
-    builder.run(rounds);
+    builder.attach({
+        .name = "binary-threshold-split-erode-cube" + suffix,
+        .type = "single",
+        .post = save_binary_sample,
+        .func = [&] {
+            q.parallel_for(binary->size, PackKernel<T>(d_input->self, d_binary_temp->self, threshold)).wait();
+            for (int i = 1; i <= dimensions; ++i)
+                if (i & 0b1)
+                    q.parallel_for(binary->size, BinaryErodeKernel(d_binary_temp->self, d_binary_output->self, d_cube_window_array[i]->self)).wait();
+                else
+                    q.parallel_for(binary->size, BinaryErodeKernel(d_binary_output->self, d_binary_temp->self, d_cube_window_array[i]->self)).wait();
+            if (!(dimensions & 0b1))
+                q.copy(d_binary_temp->data, d_binary_output->data, binary->size).wait();
+        },
+    });
+    for (size_t round = 0; round < rounds; ++round) {
+        co_await std::suspend_always();
+        builder.run(round, header);
+    }
 
     image_destroy(image);
+    image_destroy(sample);
+    binary_image_destroy(binary);
+    binary_image_destroy_device(d_binary_input, q);
+    binary_image_destroy_device(d_binary_output, q);
+    binary_image_destroy_device(d_binary_temp, q);
     image_destroy_device(d_input, q);
     image_destroy_device(d_output, q);
     image_destroy_device(d_temp, q);
+    image_destroy_device(d_extra, q);
+    device_free(d_partial_histogram, q);
+    device_free(d_histogram, q);
+    device_free(d_level, q);
+    device_free(d_statistics, q);
+    image_destroy(labels);
+    image_destroy_device(d_labels, q);
+    image_destroy_device(d_mask, q);
+    image_destroy(distances);
+    image_destroy_device(d_distances, q);
+    image_destroy_device(d_distances_temp, q);
+    device_free(d_distance_vertex, q);
+    device_free(d_distance_boundary, q);
+    image_destroy_device(d_blur, q);
+    image_destroy_device(d_blur_temp, q);
+    for (size_t s = 0; s < gaussian_sigmas.size(); ++s)
+        for (int i = 1; i <= dimensions; ++i)
+            window_destroy_device(d_gaussian_window_array[s * (dimensions + 1) + i], q);
     window_destroy_device(d_cross_window, q);
     window_destroy_device(d_cube_window, q);
+    window_destroy_device(d_cross_leading_window, q);
+    window_destroy_device(d_cross_trailing_window, q);
+    window_destroy_device(d_cube_leading_window, q);
+    window_destroy_device(d_cube_trailing_window, q);
+    image_destroy(reference);
+    for (int b = 1; b < pipeline->count; ++b)
+        image_destroy_device(d_pipeline_buffers[b], q);
+    pipeline_plan_destroy(pipeline);
+    for (auto const& batch : batches) {
+        for (int b = 0; b < batch.count; ++b) {
+            image_volume_destroy_device(batch.d_input_volumes[b], q);
+            image_volume_destroy_device(batch.d_output_volumes[b], q);
+        }
+        image_destroy_device(batch.d_input, q);
+        image_destroy_device(batch.d_output, q);
+    }
+    window_destroy_device(d_batch_cube_window, q);
+    window_destroy_device(d_batch_mean_window, q);
+    if (dimensions == 5) {
+        for (size_t b = 0; b < d_axes_input_volumes.size(); ++b) {
+            image_volume_destroy_device(d_axes_input_volumes[b], q);
+            image_volume_destroy_device(d_axes_output_volumes[b], q);
+        }
+        window_destroy_device(d_volume_cube_window, q);
+        window_destroy_device(d_axes_cube_window, q);
+    }
+    for (auto const& layout : layouts) {
+        bricked_image_destroy(layout.bricked);
+        bricked_image_destroy_device(layout.d_input, q);
+        bricked_image_destroy_device(layout.d_output, q);
+        bricked_image_destroy_device(layout.d_temp, q);
+    }
+    for (auto const& strel : strels) {
+        window_destroy_device(strel.d_window, q);
+        for (auto d_step : strel.d_steps)
+            window_destroy_device(d_step, q);
+        strel_plan_destroy(strel.plan);
+    }
+    for (auto const& psf : psfs) {
+        fft_plan_destroy(psf.plan);
+        fft_plan_destroy_device(psf.d_plan, q);
+        window_destroy_device(psf.d_window, q);
+    }
+    device_free(d_fft_data, q);
+    device_free(d_fft_scratch, q);
     window_destroy_device(d_mean_window, q);
     for (auto i = 1; i <= dimensions; ++i) {
         window_destroy_device(d_cube_window_array[i], q);
@@ -385,3 +2679,21 @@ void benchmark(VglImage* vglimage, size_t rounds, std::function<void(VglImage*,
     delete[] d_cube_window_array;
     delete[] d_mean_window_array;
 }
+
+BenchmarkSession benchmark(VglImage* vglimage, size_t rounds, std::function<void(VglImage*, std::string)> save_image)
+{
+    sycl::queue q;
+
+    auto source = image_from_vglimage<uint8_t>(vglimage);
+
+    co_yield benchmark_voxel<uint8_t>(source, vglimage, rounds, save_image, q, true);
+    co_yield benchmark_voxel<uint16_t>(source, vglimage, rounds, save_image, q, false);
+    co_yield benchmark_voxel<float>(source, vglimage, rounds, save_image, q, false);
+
+    image_destroy(source);
+}
+
+BENCHMARK_PLUGIN_EXPORT BenchmarkPlugin const benchmark_plugin = {
+    .version = BENCHMARK_PLUGIN_VERSION,
+    .setup = benchmark,
+};
@@ -13,7 +13,7 @@
 #    define FORCE_BUFFER (true)
 #endif
 
-void benchmark_nd(VglImage* input, size_t rounds, std::function<void(VglImage*, std::string)> save_image)
+BenchmarkSession benchmark_nd(VglImage* input, size_t rounds, std::function<void(VglImage*, std::string)> save_image)
 {
     vglClInit();
     vglClForceAsBuf(input);
@@ -116,6 +116,51 @@ void benchmark_nd(VglImage* input, size_t rounds, std::function<void(VglImage*,
                 vglClNdCopy(tmp, output);
         },
     });
+    builder.attach({
+        .name = "dilate-cross",
+        .type = "single",
+        .post = save_sample,
+        .func = [&] { vglClNdDilate(input, output, &strel_cross); },
+    });
+    builder.attach({
+        .name = "dilate-cube",
+        .type = "single",
+        .post = save_sample,
+        .func = [&] { vglClNdDilate(input, output, &strel_cube); },
+    });
+    builder.attach({
+        .name = "split-dilate-cube",
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            vglClNdDilate(input, tmp, strel_cube_array[1]);
+            for (int i = 2; i <= dimensions; ++i)
+                if (i & 0b1)
+                    vglClNdDilate(output, tmp, strel_cube_array[i]);
+                else
+                    vglClNdDilate(tmp, output, strel_cube_array[i]);
+            if (dimensions & 0b1)
+                vglClNdCopy(tmp, output);
+        },
+    });
+    builder.attach({
+        .name = "open-cube",
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            vglClNdErode(input, tmp, &strel_cube);
+            vglClNdDilate(tmp, output, &strel_cube);
+        },
+    });
+    builder.attach({
+        .name = "close-cube",
+        .type = "single",
+        .post = save_sample,
+        .func = [&] {
+            vglClNdDilate(input, tmp, &strel_cube);
+            vglClNdErode(tmp, output, &strel_cube);
+        },
+    });
     builder.attach({
         .name = "convolve",
         .type = "single",
@@ -137,7 +182,10 @@ void benchmark_nd(VglImage* input, size_t rounds, std::function<void(VglImage*,
                 vglClNdCopy(tmp, output);
         },
     });
-    builder.run(rounds);
+    for (size_t round = 0; round < rounds; ++round) {
+        co_await std::suspend_always();
+        builder.run(round);
+    }
 
     delete output;
     delete tmp;
@@ -147,7 +195,7 @@ void benchmark_nd(VglImage* input, size_t rounds, std::function<void(VglImage*,
     }
 }
 
-void benchmark_2d(VglImage* input, size_t rounds, std::function<void(VglImage*, std::string)> save_image)
+BenchmarkSession benchmark_2d(VglImage* input, size_t rounds, std::function<void(VglImage*, std::string)> save_image)
 {
     vglClInit();
 
@@ -242,13 +290,16 @@ void benchmark_2d(VglImage* input, size_t rounds, std::function<void(VglImage*,
             vglClConvolution(tmp, output, strel_mean_1d.getData(), strel_mean_1d.getShape()[VGL_SHAPE_HEIGHT], strel_mean_1d.getShape()[VGL_SHAPE_WIDTH]);
         },
     });
-    builder.run(rounds);
+    for (size_t round = 0; round < rounds; ++round) {
+        co_await std::suspend_always();
+        builder.run(round);
+    }
 
     delete output;
     delete tmp;
 }
 
-void benchmark_3d(VglImage* input, size_t rounds, std::function<void(VglImage*, std::string)> save_image)
+BenchmarkSession benchmark_3d(VglImage* input, size_t rounds, std::function<void(VglImage*, std::string)> save_image)
 {
     vglClInit();
 
@@ -345,19 +396,27 @@ void benchmark_3d(VglImage* input, size_t rounds, std::function<void(VglImage*,
             vglCl3dConvolution(tmp, output, strel_mean_1d.getData(), strel_mean_1d.getShape()[VGL_SHAPE_D3], strel_mean_1d.getShape()[VGL_SHAPE_D2], strel_mean_1d.getShape()[VGL_SHAPE_D1]);
         },
     });
-    builder.run(rounds);
+    for (size_t round = 0; round < rounds; ++round) {
+        co_await std::suspend_always();
+        builder.run(round);
+    }
 
     delete output;
     delete tmp;
 }
 
-void benchmark(VglImage* image, size_t rounds, std::function<void(VglImage*, std::string)> save_image)
+BenchmarkSession benchmark(VglImage* image, size_t rounds, std::function<void(VglImage*, std::string)> save_image)
 {
     if (FORCE_BUFFER || image->ndim < 2 || image->ndim > 3) {
-        benchmark_nd(image, rounds, save_image);
+        return benchmark_nd(image, rounds, save_image);
     } else if (image->ndim == 2) {
-        benchmark_2d(image, rounds, save_image);
+        return benchmark_2d(image, rounds, save_image);
     } else /* (image->ndim == 3) */ {
-        benchmark_3d(image, rounds, save_image);
+        return benchmark_3d(image, rounds, save_image);
     }
 }
+
+BENCHMARK_PLUGIN_EXPORT BenchmarkPlugin const benchmark_plugin = {
+    .version = BENCHMARK_PLUGIN_VERSION,
+    .setup = benchmark,
+};